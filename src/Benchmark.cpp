@@ -0,0 +1,206 @@
+#include "LiteLog.hpp"
+#include <thread>
+#include <vector>
+
+// 多线程竞争测试：threads 个线程各记录 iterations 条日志，返回每秒总条数
+template <typename Func>
+double runContention(int threads, int iterations, Func func)
+{
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]()
+                             {
+            ready++;
+            while (!go)
+            {
+                std::this_thread::yield();
+            }
+            for (int i = 0; i < iterations; i++)
+            {
+                func(t, i);
+            } });
+    }
+
+    while (ready < threads)
+    {
+        std::this_thread::yield();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(threads) * iterations / seconds;
+}
+
+// 单线程下每次调用的平均耗时（纳秒）
+template <typename Func>
+double nanosPerCall(int iterations, Func func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        func(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+// ======================
+// 配置布局对照组
+// ======================
+// 按 Logger 拆分热配置前后的两种布局各构造一份等级配置，在相同的干扰下比较过滤吞吐。
+// 干扰线程持续写日志，并写入与等级相邻的数据（相当于 mutex_ 等频繁写入的成员）。
+
+// 拆分前：等级与频繁写入的数据位于同一缓存行
+struct alignas(64) SharedLineConfig
+{
+    std::atomic<int> level;
+    std::atomic<uint64_t> writes;
+};
+
+// 拆分后：等级单独占用缓存行
+struct SplitLineConfig
+{
+    alignas(64) std::atomic<int> level;
+    alignas(64) std::atomic<uint64_t> writes;
+};
+
+// 更早的做法：每次检查等级都加配置锁
+struct LockedConfig
+{
+    std::mutex mutex;
+    int level;
+};
+
+static SharedLineConfig shared_config;
+static SplitLineConfig split_config;
+static LockedConfig locked_config;
+static std::atomic<uint64_t> passed(0); // 防止等级检查被优化掉
+
+template <typename Config>
+inline void checkAtomicLevel(Config &config)
+{
+    if (static_cast<int>(LogLevel::Debug) >= config.level.load(std::memory_order_relaxed))
+        passed++;
+}
+
+inline void checkLockedLevel()
+{
+    std::lock_guard<std::mutex> lock(locked_config.mutex);
+    if (static_cast<int>(LogLevel::Debug) >= locked_config.level)
+        passed++;
+}
+
+// 测试期间持续写日志并写入各对照组的相邻数据
+class Interference
+{
+public:
+    Interference() : stop_(false)
+    {
+        thread_ = std::thread([this]()
+                              {
+            int i = 0;
+            while (!stop_.load(std::memory_order_relaxed))
+            {
+                LOG_INFO("interference %d", i++);
+                shared_config.writes.fetch_add(1, std::memory_order_relaxed);
+                split_config.writes.fetch_add(1, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> lock(locked_config.mutex);
+            } });
+    }
+
+    ~Interference()
+    {
+        stop_ = true;
+        thread_.join();
+    }
+
+private:
+    std::atomic<bool> stop_;
+    std::thread thread_;
+};
+
+// 代价较高的日志参数，统计被求值的次数
+static std::atomic<int> expensive_calls(0);
+
+static std::string expensiveArgument(int i)
+{
+    expensive_calls++;
+    return "object#" + std::to_string(i);
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+    const int thread_counts[] = {1, 2, 4, 8, 16, 32, 64};
+
+    Logger::instance().setLevel(LogLevel::Info);
+    Logger::instance().consoleOutput(false);
+#ifdef _WIN32
+    Logger::instance().setLogFile("NUL", false);
+#else
+    Logger::instance().setLogFile("/dev/null", false);
+#endif
+
+    shared_config.level = static_cast<int>(LogLevel::Info);
+    split_config.level = static_cast<int>(LogLevel::Info);
+    locked_config.level = static_cast<int>(LogLevel::Info);
+
+    // 被过滤的等级检查（M/s），干扰线程同时在写日志
+    std::printf("%-8s %14s %14s %14s %14s %14s\n", "threads", "Logger hot_", "split line", "shared line",
+                "locked", "written");
+    for (int threads : thread_counts)
+    {
+        double hot, split, shared, locked;
+        {
+            Interference interference;
+
+            // Logger 的过滤路径：绕过宏的等级闸门，读取 hot_
+            hot = runContention(threads, iterations, [](int, int)
+                                {
+                if (Logger::instance().isEnabled(LogLevel::Debug))
+                    passed++; });
+            split = runContention(threads, iterations, [](int, int)
+                                  { checkAtomicLevel(split_config); });
+            shared = runContention(threads, iterations, [](int, int)
+                                   { checkAtomicLevel(shared_config); });
+            locked = runContention(threads, iterations / 10, [](int, int)
+                                   { checkLockedLevel(); });
+        }
+
+        // 实际写出的日志：格式化并写入 /dev/null
+        double written = runContention(threads, iterations / 10, [](int t, int i)
+                                       { LOG_INFO("written %d %d", t, i); });
+
+        std::printf("%-8d %14.2f %14.2f %14.2f %14.2f %14.2f\n", threads, hot / 1e6, split / 1e6, shared / 1e6,
+                    locked / 1e6, written / 1e6);
+    }
+
+    // 被过滤日志的开销：宏先检查等级闸门，参数不会被求值
+    int calls = iterations * 50;
+    double printf_style = nanosPerCall(calls, [](int i)
+                                       { LOG_DEBUG_T("NETWORK", "%s", expensiveArgument(i).c_str()); });
+    double stream_style = nanosPerCall(calls, [](int i)
+                                       { LOG_DEBUG_S("NETWORK") << expensiveArgument(i); });
+    double direct_call = nanosPerCall(calls, [](int i)
+                                      { Logger::instance().log(LogLevel::Debug, "NETWORK", __FILE__, __LINE__, __func__, "%d", i); });
+
+    std::printf("\n%-32s %12s\n", "disabled LOG_DEBUG", "ns/call");
+    std::printf("%-32s %12.2f\n", "LOG_DEBUG_T(tag, fmt, ...)", printf_style);
+    std::printf("%-32s %12.2f\n", "LOG_DEBUG_S(tag) << expr", stream_style);
+    std::printf("%-32s %12.2f\n", "Logger::log() without gate", direct_call);
+    std::printf("expensive arguments evaluated: %d\n", expensive_calls.load());
+
+    Logger::instance().shutdown();
+    return 0;
+}
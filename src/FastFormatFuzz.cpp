@@ -0,0 +1,192 @@
+// FastFormatter 差分测试：用随机的数值、精度和长度修饰分别调用 FastFormatter::format
+// 和 vsnprintf，比较两者输出是否逐字节一致。FastFormatter 返回 false（改用 vsnprintf）
+// 的用例只计数，不算不一致。
+//
+// 用法: litelog_fastformat_fuzz [用例数] [随机种子]
+// 全部一致时返回 0，否则打印前几个不一致的用例并返回 1。
+
+#include "LiteLog.hpp"
+#include <cfloat>
+#include <cinttypes>
+#include <cmath>
+#include <random>
+
+namespace
+{
+
+struct FuzzStats
+{
+    uint64_t cases = 0;      // 用例总数
+    uint64_t fallbacks = 0;  // FastFormatter 返回 false 的用例数
+    uint64_t mismatches = 0; // 输出不一致的用例数
+};
+
+// 用同一组参数分别格式化并比较
+bool check(FuzzStats &stats, const char *format, ...)
+{
+    char expected[512];
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    std::vsnprintf(expected, sizeof(expected), format, copy);
+    va_end(copy);
+
+    LogRecord *record = RecordPool::acquire();
+    bool handled = FastFormatter::format(*record, format, args);
+    va_end(args);
+
+    stats.cases++;
+    bool ok = true;
+    if (!handled)
+    {
+        stats.fallbacks++;
+        ok = record->size() == 0; // 失败时不应留下部分输出
+    }
+    else
+    {
+        ok = record->size() == std::strlen(expected) &&
+             std::memcmp(record->data(), expected, record->size()) == 0;
+    }
+
+    if (!ok)
+    {
+        if (stats.mismatches < 10)
+        {
+            std::printf("mismatch: format=\"%s\"\n  vsnprintf: \"%s\"\n  fast:      \"%.*s\"%s\n", format, expected,
+                        static_cast<int>(record->size()), record->data(), handled ? "" : " (fallback)");
+        }
+        stats.mismatches++;
+    }
+    RecordPool::release(record);
+    return ok;
+}
+
+// 随机 double：均匀分布、随机量级、二进制小数（容易落在舍入的中点上）以及任意位模式
+double randomDouble(std::mt19937_64 &rng)
+{
+    switch (rng() % 6)
+    {
+    case 0:
+        return std::uniform_real_distribution<double>(-1000.0, 1000.0)(rng);
+    case 1:
+    {
+        double mantissa = std::uniform_real_distribution<double>(-10.0, 10.0)(rng);
+        return mantissa * std::pow(10.0, static_cast<int>(rng() % 41) - 20);
+    }
+    case 2:
+        // k / 2^n：小数位数有限，常常恰好在某个精度的中点上
+        return static_cast<double>(static_cast<int64_t>(rng() % 2000001) - 1000000) /
+               static_cast<double>(1ULL << (rng() % 20));
+    case 3:
+        return static_cast<double>(static_cast<int64_t>(rng() % 200001) - 100000) + 0.5;
+    case 4:
+    {
+        static const double specials[] = {0.0, -0.0, 0.5, 1.5, 2.5, 0.05, 0.15, 0.25, 0.35, 1e-300,
+                                          DBL_MIN, 4.9406564584124654e-324, 9007199254740993.0, 1.8446744073709552e19,
+                                          18446744073709549568.0, 1e19, -1e19, DBL_MAX, HUGE_VAL, NAN};
+        return specials[rng() % (sizeof(specials) / sizeof(specials[0]))];
+    }
+    default:
+    {
+        uint64_t bits = rng();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    }
+}
+
+// 随机整数：偏向边界值和较小的数
+uint64_t randomBits(std::mt19937_64 &rng)
+{
+    switch (rng() % 4)
+    {
+    case 0:
+        return rng() % 1000;
+    case 1:
+        return ~0ULL - rng() % 1000;
+    case 2:
+        return rng() >> (rng() % 64);
+    default:
+        return rng();
+    }
+}
+
+void fuzzOne(FuzzStats &stats, std::mt19937_64 &rng)
+{
+    char format[64];
+    uint64_t bits = randomBits(rng);
+    switch (rng() % 8)
+    {
+    case 0:
+    {
+        static const char *const formats[] = {"%d", "%i", "x=%d;", "%u", "%x", "%X"};
+        std::snprintf(format, sizeof(format), "%s", formats[rng() % 6]);
+        check(stats, format, static_cast<int>(bits));
+        break;
+    }
+    case 1:
+    {
+        static const char *const formats[] = {"%ld", "%li", "%lu", "%lx", "%lX"};
+        std::snprintf(format, sizeof(format), "[%s]", formats[rng() % 5]);
+        check(stats, format, static_cast<long>(bits));
+        break;
+    }
+    case 2:
+    {
+        static const char *const formats[] = {"%lld", "%lli", "%llu", "%llx", "%llX"};
+        std::snprintf(format, sizeof(format), "v %s v", formats[rng() % 5]);
+        check(stats, format, static_cast<long long>(bits));
+        break;
+    }
+    case 3:
+    {
+        static const char *const formats[] = {"%zu", "%zx", "%zd"};
+        std::snprintf(format, sizeof(format), "%s", formats[rng() % 3]);
+        check(stats, format, static_cast<size_t>(bits));
+        break;
+    }
+    case 4:
+    {
+        // %.Nf，N 覆盖支持范围之外的 18、19 以验证回退
+        int precision = static_cast<int>(rng() % 20);
+        std::snprintf(format, sizeof(format), "f=%%.%df", precision);
+        check(stats, format, randomDouble(rng));
+        break;
+    }
+    case 5:
+        check(stats, rng() % 2 ? "%f" : "%lf", randomDouble(rng));
+        break;
+    case 6:
+    {
+        static const char *const strings[] = {"", "abc", "DATABASE", "100%", nullptr};
+        check(stats, "%s|%c|%%|%p", strings[rng() % 5], static_cast<int>(' ' + rng() % 95),
+              rng() % 4 ? reinterpret_cast<void *>(static_cast<uintptr_t>(bits)) : nullptr);
+        break;
+    }
+    default:
+        check(stats, "%d %s %.3f %llx %zu", static_cast<int>(bits), "mixed", randomDouble(rng),
+              static_cast<unsigned long long>(bits), static_cast<size_t>(bits >> 7));
+        break;
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    uint64_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : std::random_device()();
+
+    std::mt19937_64 rng(seed);
+    FuzzStats stats;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        fuzzOne(stats, rng);
+    }
+
+    std::printf("seed=%" PRIu64 " cases=%" PRIu64 " fallbacks=%" PRIu64 " mismatches=%" PRIu64 "\n", seed,
+                stats.cases, stats.fallbacks, stats.mismatches);
+    return stats.mismatches == 0 ? 0 : 1;
+}
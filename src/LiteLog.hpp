@@ -48,6 +48,17 @@
 #include <stdexcept>
 #include <cctype>
 #include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <regex>
+#include <algorithm>
+#include <type_traits>
+#include <new>
 
 // 添加必要的系统头文件
 #ifdef _WIN32
@@ -57,6 +68,25 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <sched.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+// 不内联的函数：日志宏调用的冷路径放在单独的函数中，调用方只保留闸门判断和一次调用
+#ifdef _MSC_VER
+#define LITELOG_NOINLINE __declspec(noinline)
+#else
+#define LITELOG_NOINLINE __attribute__((noinline))
 #endif
 
 // ======================
@@ -132,21 +162,2172 @@ enum class ColorMode
     LINE     // 整行彩色输出
 };
 
-// ======================
-// 标签颜色配置
-// ======================
-struct TagConfig
-{
-    const char *color = ansi::cyan; // 标签文本颜色
-    const char *style = "";         // 标签文本样式
-    bool enabled = true;            // 是否启用该标签的日志
+// ======================
+// 标签颜色配置
+// ======================
+struct TagConfig
+{
+    const char *color = ansi::cyan; // 标签文本颜色
+    const char *style = "";         // 标签文本样式
+    bool enabled = true;            // 是否启用该标签的日志
+
+    TagConfig() {}
+
+    TagConfig(const char *_color, const char *_style, bool _enabled)
+        : color(_color), style(_style), enabled(_enabled)
+    {
+    }
+};
+
+// ======================
+// 日志等级闸门
+// ======================
+// 所有等级下限中的最小值（关闭后为 OFF），由 Logger 在配置变更时更新。
+// 静态成员常量初始化，日志宏在求值参数之前只读取这一个原子变量，
+// 不经过 Logger::instance() 的局部静态变量检查。单独占用一条缓存行，
+// 不会与程序中其他频繁写入的全局变量伪共享。
+struct alignas(64) LogGateLevel
+{
+    std::atomic<int> value;
+
+    constexpr explicit LogGateLevel(int level) : value(level) {}
+
+    int load(std::memory_order order) const
+    {
+        return value.load(order);
+    }
+
+    void store(int level, std::memory_order order)
+    {
+        value.store(level, order);
+    }
+};
+
+static_assert(sizeof(LogGateLevel) == 64, "log gate must fill one cache line");
+
+template <typename T = void>
+struct LogGateStorage
+{
+    static LogGateLevel min_level;
+};
+
+template <typename T>
+LogGateLevel LogGateStorage<T>::min_level(static_cast<int>(LogLevel::Info));
+
+typedef LogGateStorage<> LogGate;
+
+class RecordPool;
+
+// ======================
+// 日志记录
+// ======================
+// 一条（或一批）格式化后的日志。短日志直接存放在内嵌缓冲区中，超出部分扩展到
+// 堆上，扩展出的缓冲区随记录一起回收复用。记录由 RecordPool 分配，以指针形式
+// 经过格式化 -> 队列 -> 输出，不做复制；控制台和文件两个异步队列各用一个链接字段，
+// 同一条记录可同时位于两个队列中，由引用计数决定何时回收。
+class LogRecord
+{
+public:
+    static const size_t kInlineSize = 448;       // 内嵌缓冲区大小
+    static const size_t kMaxRetained = 64 << 10; // 回收时保留的最大扩展缓冲区
+
+    // 链接字段下标（空闲链表使用 kConsoleLink）
+    enum Link
+    {
+        kConsoleLink = 0,
+        kFileLink = 1,
+        kLinkCount
+    };
+
+    LogLevel level;              // 日志等级
+    LogRecord *next[kLinkCount]; // 各队列中的下一条
+    uint64_t console_seq;        // 在控制台队列中的序号
+
+    const char *data() const
+    {
+        return data_;
+    }
+
+    char *data()
+    {
+        return data_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    void clear()
+    {
+        size_ = 0;
+    }
+
+    void reserve(size_t capacity)
+    {
+        if (capacity > capacity_)
+            grow(capacity);
+    }
+
+    void resize(size_t size)
+    {
+        reserve(size);
+        size_ = size;
+    }
+
+    void append(const char *data, size_t size)
+    {
+        reserve(size_ + size);
+        std::memcpy(data_ + size_, data, size);
+        size_ += size;
+    }
+
+    LogRecord &operator+=(const char *str)
+    {
+        append(str, std::strlen(str));
+        return *this;
+    }
+
+    LogRecord &operator+=(const std::string &str)
+    {
+        append(str.data(), str.size());
+        return *this;
+    }
+
+    LogRecord &operator+=(char c)
+    {
+        reserve(size_ + 1);
+        data_[size_++] = c;
+        return *this;
+    }
+
+    // 增加引用（每多一个异步输出持有该记录时调用）
+    void addRef()
+    {
+        refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    friend class RecordPool;
+
+    LogRecord()
+        : level(LogLevel::Info), console_seq(0), data_(inline_), size_(0), capacity_(kInlineSize), refs_(0),
+          pool_(nullptr)
+    {
+        next[kConsoleLink] = next[kFileLink] = nullptr;
+    }
+
+    ~LogRecord()
+    {
+        if (data_ != inline_)
+            delete[] data_;
+    }
+
+    LogRecord(const LogRecord &) = delete;
+    LogRecord &operator=(const LogRecord &) = delete;
+
+    void grow(size_t capacity)
+    {
+        size_t new_capacity = std::max(capacity, capacity_ * 2);
+        char *new_data = new char[new_capacity];
+        std::memcpy(new_data, data_, size_);
+        if (data_ != inline_)
+            delete[] data_;
+        data_ = new_data;
+        capacity_ = new_capacity;
+    }
+
+    // 回收前释放过大的扩展缓冲区
+    void shrink()
+    {
+        if (capacity_ > kMaxRetained)
+        {
+            delete[] data_;
+            data_ = inline_;
+            capacity_ = kInlineSize;
+        }
+        size_ = 0;
+    }
+
+    char *data_;
+    size_t size_;
+    size_t capacity_;
+    std::atomic<int> refs_; // 引用计数
+    RecordPool *pool_;      // 所属线程的池
+    char inline_[kInlineSize];
+};
+
+// ======================
+// 日志记录池
+// ======================
+// 每个线程一个池。所属线程从本地空闲链表取记录；其他线程（写出线程）归还的记录
+// 通过无锁栈放回，所属线程取空本地链表后一次性接管整个栈，因此不存在 ABA 问题。
+// 稳定运行后分配和回收记录都不调用内存分配器。线程退出后池在最后一条记录归还时释放。
+class RecordPool
+{
+public:
+    // 从当前线程的池中取一条空记录（引用计数为 1）
+    static LogRecord *acquire()
+    {
+        RecordPool *pool = current();
+        if (!pool)
+        {
+            if (exited())
+            {
+                // 线程局部对象析构期间记录的日志，不经过池
+                LogRecord *record = new LogRecord();
+                record->refs_.store(1, std::memory_order_relaxed);
+                return record;
+            }
+            pool = holder().pool;
+        }
+
+        LogRecord *record = pool->free_;
+        if (!record)
+        {
+            record = pool->returned_.exchange(nullptr, std::memory_order_acquire);
+        }
+        if (record)
+        {
+            pool->free_ = record->next[LogRecord::kConsoleLink];
+        }
+        else
+        {
+            record = new LogRecord();
+            record->pool_ = pool;
+        }
+
+        pool->refs_.fetch_add(1, std::memory_order_relaxed);
+        record->next[LogRecord::kConsoleLink] = record->next[LogRecord::kFileLink] = nullptr;
+        record->refs_.store(1, std::memory_order_relaxed);
+        return record;
+    }
+
+    // 释放一个引用，引用归零时把记录还给所属线程的池（可在任意线程调用）
+    static void release(LogRecord *record)
+    {
+        if (record->refs_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+
+        RecordPool *pool = record->pool_;
+        if (!pool)
+        {
+            delete record;
+            return;
+        }
+
+        record->shrink();
+        if (pool == current())
+        {
+            record->next[LogRecord::kConsoleLink] = pool->free_;
+            pool->free_ = record;
+        }
+        else
+        {
+            LogRecord *head = pool->returned_.load(std::memory_order_relaxed);
+            do
+            {
+                record->next[LogRecord::kConsoleLink] = head;
+            } while (!pool->returned_.compare_exchange_weak(head, record, std::memory_order_release,
+                                                            std::memory_order_relaxed));
+        }
+
+        if (pool->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete pool;
+    }
+
+private:
+    // 线程退出时解除池与线程的关联
+    struct Holder
+    {
+        RecordPool *pool;
+
+        Holder() : pool(new RecordPool())
+        {
+            current() = pool;
+        }
+
+        ~Holder()
+        {
+            current() = nullptr;
+            exited() = true;
+            pool->orphan();
+        }
+    };
+
+    RecordPool() : free_(nullptr), returned_(nullptr), refs_(1) {}
+
+    ~RecordPool()
+    {
+        freeList(free_);
+        freeList(returned_.exchange(nullptr, std::memory_order_acquire));
+    }
+
+    static Holder &holder()
+    {
+        static thread_local Holder holder;
+        return holder;
+    }
+
+    static RecordPool *&current()
+    {
+        static thread_local RecordPool *pool = nullptr;
+        return pool;
+    }
+
+    static bool &exited()
+    {
+        static thread_local bool exited = false;
+        return exited;
+    }
+
+    // 所属线程退出：释放空闲记录，仍在途的记录归还后再释放池
+    void orphan()
+    {
+        freeList(free_);
+        free_ = nullptr;
+        freeList(returned_.exchange(nullptr, std::memory_order_acquire));
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
+    static void freeList(LogRecord *record)
+    {
+        while (record)
+        {
+            LogRecord *next = record->next[LogRecord::kConsoleLink];
+            delete record;
+            record = next;
+        }
+    }
+
+    LogRecord *free_;                   // 本地空闲链表（仅所属线程访问）
+    std::atomic<LogRecord *> returned_; // 其他线程归还的记录
+    std::atomic<size_t> refs_;          // 所属线程 + 在途记录数
+};
+
+// ======================
+// 控制台输出统计
+// ======================
+struct ConsoleSinkStats
+{
+    uint64_t written_bytes = 0;         // 已写入 stderr 的字节数
+    uint64_t dropped_records = 0;       // 因缓冲区已满被丢弃的日志条数
+    uint64_t dropped_bytes = 0;         // 因缓冲区已满被丢弃的字节数
+    uint64_t dropped_error_records = 0; // 其中 Error/Fatal 级别的丢弃条数
+};
+
+// ======================
+// 异步控制台输出
+// ======================
+// 日志线程只把日志放入有界缓冲区，由独立的写出线程写入 stderr。stderr 的打开文件
+// 描述可能与 stdout、终端或父进程共享，因此不修改其阻塞属性，写出线程每次写之前
+// 先 poll 等待可写并限制单次写入长度，停止时的等待时间由此得到保证。
+// stderr 管道阻塞时缓冲区逐渐填满，此时优先丢弃低等级日志：新日志可以挤掉
+// 缓冲区中等级比它低的旧日志，Error/Fatal 另外还有一段预留空间。
+// 每个等级一个队列并记录字节数，挤不出空间时不遍历队列直接丢弃；写出线程按序号
+// 合并各队列，每次只取 kSliceBytes 字节，未取出的日志仍然可以被挤掉。
+class AsyncConsoleSink
+{
+public:
+    static const size_t kSliceBytes = 4096; // 写出线程每次从队列取出的字节数
+
+    explicit AsyncConsoleSink(size_t capacity_bytes)
+        : capacity_(capacity_bytes < 1024 ? 1024 : capacity_bytes),
+          reserved_(capacity_ / 8),
+          queued_bytes_(0),
+          inflight_bytes_(0),
+          next_seq_(0),
+          stop_(false)
+#ifndef _WIN32
+          ,
+          fd_(STDERR_FILENO)
+#endif
+    {
+    }
+
+    ~AsyncConsoleSink()
+    {
+        stop();
+    }
+
+    // 启动写出线程
+    void start()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (thread_.joinable())
+            return;
+
+        stop_ = false;
+        thread_ = std::thread(&AsyncConsoleSink::drainLoop, this);
+    }
+
+    // 停止写出线程，最多等待 timeout 把剩余日志写完，返回是否全部写出
+    bool stop(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000))
+    {
+        uint64_t dropped_before = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!thread_.joinable())
+                return true;
+            dropped_before = stats_.dropped_bytes;
+            stop_ = true;
+            stop_deadline_ = std::chrono::steady_clock::now() + timeout;
+        }
+        cv_.notify_all();
+        thread_.join();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_.dropped_bytes == dropped_before;
+    }
+
+    // 等待缓冲区中的日志全部写出，最多等待 timeout
+    bool flush(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!thread_.joinable())
+            return queued_bytes_ == 0;
+        return drained_cv_.wait_for(lock, timeout, [this]
+                                    { return queued_bytes_ == 0 && inflight_bytes_ == 0; });
+    }
+
+    // 放入一条日志（需自带换行），队列持有记录的一个引用，返回 false 表示被丢弃
+    bool push(LogRecord *record)
+    {
+        const LogLevel level = record->level;
+        const size_t size = record->size();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            size_t limit = level >= LogLevel::Error ? capacity_ : capacity_ - reserved_;
+            size_t used = queued_bytes_ + inflight_bytes_;
+            if (used + size > limit && !evictBelow(level, used + size - limit))
+            {
+                countDropped(level, size);
+                return false;
+            }
+
+            record->addRef();
+            record->console_seq = next_seq_++;
+            record->next[LogRecord::kConsoleLink] = nullptr;
+            LevelQueue &queue = queues_[static_cast<int>(level)];
+            if (queue.tail)
+                queue.tail->next[LogRecord::kConsoleLink] = record;
+            else
+                queue.head = record;
+            queue.tail = record;
+            queue.bytes += size;
+            queued_bytes_ += size;
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+    // 获取统计信息
+    ConsoleSinkStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    static const int kLevelCount = static_cast<int>(LogLevel::Fatal) + 1;
+
+    struct LevelQueue
+    {
+        LogRecord *head = nullptr;
+        LogRecord *tail = nullptr;
+        size_t bytes = 0; // 队列中的字节数
+    };
+
+    // 按等级从低到高挤掉比 level 低的旧日志，直到腾出 needed 字节。
+    // 低等级日志总量不够时不挤掉任何日志，返回 false
+    bool evictBelow(LogLevel level, size_t needed)
+    {
+        size_t evictable = 0;
+        for (int victim = 0; victim < static_cast<int>(level); ++victim)
+        {
+            evictable += queues_[victim].bytes;
+        }
+        if (evictable < needed)
+            return false;
+
+        size_t freed = 0;
+        for (int victim = 0; freed < needed; ++victim)
+        {
+            LevelQueue &queue = queues_[victim];
+            while (queue.head && freed < needed)
+            {
+                LogRecord *record = popFront(queue);
+                freed += record->size();
+                countDropped(record->level, record->size());
+                RecordPool::release(record);
+            }
+        }
+        return true;
+    }
+
+    // 取出队列头部的日志
+    LogRecord *popFront(LevelQueue &queue)
+    {
+        LogRecord *record = queue.head;
+        queue.head = record->next[LogRecord::kConsoleLink];
+        if (!queue.head)
+            queue.tail = nullptr;
+        queue.bytes -= record->size();
+        queued_bytes_ -= record->size();
+        return record;
+    }
+
+    // 取出序号最小（最早放入）的日志，队列全空时返回 nullptr
+    LogRecord *popOldest()
+    {
+        LevelQueue *oldest = nullptr;
+        for (auto &queue : queues_)
+        {
+            if (queue.head && (!oldest || queue.head->console_seq < oldest->head->console_seq))
+                oldest = &queue;
+        }
+        return oldest ? popFront(*oldest) : nullptr;
+    }
+
+    void countDropped(LogLevel level, size_t bytes)
+    {
+        stats_.dropped_records++;
+        stats_.dropped_bytes += bytes;
+        if (level >= LogLevel::Error)
+        {
+            stats_.dropped_error_records++;
+        }
+    }
+
+    // 写出线程主循环
+    void drainLoop()
+    {
+        std::string buffer; // 合并写出的缓冲区，容量跨批次复用
+        for (;;)
+        {
+            LogRecord *batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]
+                         { return stop_ || queued_bytes_ != 0; });
+                if (queued_bytes_ == 0)
+                    return; // 已停止且没有剩余日志
+                if (stop_ && std::chrono::steady_clock::now() >= stop_deadline_)
+                {
+                    // 停止超时，剩余日志无法写出
+                    while (LogRecord *record = popOldest())
+                    {
+                        countDropped(record->level, record->size());
+                        RecordPool::release(record);
+                    }
+                    drained_cv_.notify_all();
+                    return;
+                }
+
+                // 按放入顺序取出一段，至少一条
+                LogRecord **link = &batch;
+                size_t bytes = 0;
+                while (bytes < kSliceBytes)
+                {
+                    LogRecord *record = popOldest();
+                    if (!record)
+                        break;
+                    bytes += record->size();
+                    *link = record;
+                    link = &record->next[LogRecord::kConsoleLink];
+                }
+                *link = nullptr;
+                inflight_bytes_ = bytes;
+            }
+
+            buffer.clear();
+            while (batch)
+            {
+                LogRecord *next = batch->next[LogRecord::kConsoleLink];
+                buffer.append(batch->data(), batch->size());
+                RecordPool::release(batch);
+                batch = next;
+            }
+
+            size_t written = writeAll(buffer);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.written_bytes += written;
+            if (written < buffer.size())
+            {
+                // 停止超时，剩余内容无法写出
+                stats_.dropped_bytes += buffer.size() - written;
+            }
+            inflight_bytes_ = 0;
+            drained_cv_.notify_all();
+        }
+    }
+
+    // 写出整块数据，返回实际写出的字节数
+    size_t writeAll(const std::string &data)
+    {
+#ifdef _WIN32
+        size_t written = std::fwrite(data.data(), 1, data.size(), stderr);
+        std::fflush(stderr);
+        return written;
+#else
+        size_t written = 0;
+        while (written < data.size())
+        {
+            // 等待可写；管道已满时每 100ms 检查一次，停止后超过期限则放弃
+            struct pollfd pfd;
+            pfd.fd = fd_;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            int ready = ::poll(&pfd, 1, 100);
+            if (ready < 0 && errno != EINTR)
+                break;
+            if (ready > 0 && (pfd.revents & (POLLERR | POLLNVAL)))
+                break; // 管道已关闭等不可恢复错误
+            if (ready <= 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stop_ && std::chrono::steady_clock::now() >= stop_deadline_)
+                    break;
+                continue;
+            }
+
+            // 可写时管道至少有 PIPE_BUF 字节空闲，单次写入不超过它就不会阻塞
+            size_t chunk = std::min(data.size() - written, static_cast<size_t>(PIPE_BUF));
+            ssize_t n = ::write(fd_, data.data() + written, chunk);
+            if (n > 0)
+                written += static_cast<size_t>(n);
+            else if (n < 0 && errno != EINTR && errno != EAGAIN)
+                break;
+        }
+        return written;
+#endif
+    }
+
+    const size_t capacity_;          // 缓冲区容量（字节）
+    const size_t reserved_;          // 为 Error/Fatal 预留的容量
+    size_t queued_bytes_;            // 各队列中的字节数之和
+    size_t inflight_bytes_;          // 写出线程正在写的字节数
+    uint64_t next_seq_;              // 下一条日志的序号
+    LevelQueue queues_[kLevelCount]; // 每个等级的待写出队列
+    ConsoleSinkStats stats_;
+
+    bool stop_;
+    std::chrono::steady_clock::time_point stop_deadline_;
+    std::thread thread_;
+    std::condition_variable cv_;         // 通知写出线程有新日志
+    std::condition_variable drained_cv_; // 通知缓冲区已写空
+    mutable std::mutex mutex_;
+
+#ifndef _WIN32
+    int fd_; // stderr 文件描述符
+#endif
+};
+
+// ======================
+// 内存日志查询条件
+// ======================
+struct LogFilter
+{
+    LogLevel min_level = LogLevel::Trace; // 最低日志等级
+    std::string tag;                      // 标签（为空表示不限）
+    std::string pattern;                  // 正则表达式，匹配整行日志（为空表示不限）
+};
+
+// ======================
+// 内存中的日志记录
+// ======================
+struct MemoryLogRecord
+{
+    LogLevel level;                             // 日志等级
+    std::chrono::system_clock::time_point time; // 记录时间
+    std::string tag;                            // 标签
+    std::string text;                           // 日志行（已去除 ANSI 颜色）
+};
+
+// ======================
+// 无锁内存环形缓冲区
+// ======================
+// 固定大小的槽位按序号循环覆盖，写入方用 fetch_add 领取序号，每个槽位带一个
+// 序列号（奇数表示正在写入），读取方复制后再次校验序列号，不一致的槽位直接跳过。
+// 槽位内容按 8 字节原子字以 relaxed 方式读写，读写并发时读取方可能得到混合的内容，
+// 但会被序列号校验丢弃。写入和读取都不加锁，超长的日志行会被截断。
+class MemoryRingBuffer
+{
+public:
+    static constexpr size_t kSlotSize = 512;
+
+    explicit MemoryRingBuffer(size_t capacity_bytes)
+        : head_(0)
+    {
+        size_t count = 1;
+        while (count * kSlotSize < capacity_bytes)
+        {
+            count <<= 1;
+        }
+        slots_.reset(new Slot[count]);
+        mask_ = count - 1;
+    }
+
+    // 容量（字节）
+    size_t capacity() const
+    {
+        return (mask_ + 1) * kSlotSize;
+    }
+
+    // 写入一条日志，写入时去除 ANSI 颜色代码
+    void push(LogLevel level, const char *tag, const char *line, size_t length)
+    {
+        uint64_t index = head_.fetch_add(1, std::memory_order_relaxed);
+        Slot &slot = slots_[index & mask_];
+
+        // 只领取旧于本条的槽位：槽位正被写入（奇数），或已被领先一圈的写入方写过
+        // （序列号大于 index * 2），说明本条已经落后，直接放弃，不覆盖更新的日志。
+        // 领取成功时用 acquire，保证本次写入排在上一个写入方对该槽位的写入之后
+        uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+        if ((seq & 1) || seq > index * 2 ||
+            !slot.seq.compare_exchange_strong(seq, index * 2 + 1, std::memory_order_acquire,
+                                              std::memory_order_relaxed))
+            return;
+        std::atomic_thread_fence(std::memory_order_release);
+
+        // 先在栈上组装，再按字写入槽位
+        Payload payload;
+        payload.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count();
+        payload.level = static_cast<uint8_t>(level);
+
+        size_t tag_len = tag ? std::strlen(tag) : 0;
+        if (tag_len > sizeof(payload.tag))
+            tag_len = sizeof(payload.tag);
+        if (tag_len)
+            std::memcpy(payload.tag, tag, tag_len);
+        payload.tag_len = static_cast<uint8_t>(tag_len);
+
+        size_t text_len = 0;
+        for (size_t i = 0; i < length && text_len < sizeof(payload.text); ++i)
+        {
+            if (line[i] == '\033' && i + 1 < length && line[i + 1] == '[')
+            {
+                // 跳过 ESC [ ... m
+                i += 2;
+                while (i < length && !std::isalpha(static_cast<unsigned char>(line[i])))
+                    ++i;
+                continue;
+            }
+            payload.text[text_len++] = line[i];
+        }
+        payload.text_len = static_cast<uint16_t>(text_len);
+
+        storeWords(slot, payload, kTextOffset + text_len);
+        slot.seq.store(index * 2 + 2, std::memory_order_release);
+    }
+
+    // 读取当前缓冲区中满足条件的日志，按写入顺序返回
+    std::vector<MemoryLogRecord> snapshot(const LogFilter &filter) const
+    {
+        std::vector<MemoryLogRecord> records;
+        bool use_regex = !filter.pattern.empty();
+        std::regex re;
+        if (use_regex)
+        {
+            try
+            {
+                re.assign(filter.pattern);
+            }
+            catch (const std::regex_error &)
+            {
+                return records; // 非法的正则表达式
+            }
+        }
+
+        uint64_t head = head_.load(std::memory_order_acquire);
+        uint64_t count = mask_ + 1;
+        uint64_t begin = head > count ? head - count : 0;
+
+        Payload copy;
+        for (uint64_t index = begin; index < head; ++index)
+        {
+            const Slot &slot = slots_[index & mask_];
+            uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq != index * 2 + 2)
+                continue; // 尚未写完或已被覆盖
+
+            // 先读头部得到长度，再读文本；长度可能来自并发写入，按上限截断
+            loadWords(slot, copy, 0, kTextOffset);
+            if (copy.tag_len > sizeof(copy.tag))
+                copy.tag_len = sizeof(copy.tag);
+            if (copy.text_len > sizeof(copy.text))
+                copy.text_len = sizeof(copy.text);
+            loadWords(slot, copy, kTextOffset, kTextOffset + copy.text_len);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq)
+                continue;
+
+            if (static_cast<LogLevel>(copy.level) < filter.min_level)
+                continue;
+            if (!filter.tag.empty() &&
+                filter.tag.compare(0, std::string::npos, copy.tag, copy.tag_len) != 0)
+                continue;
+
+            MemoryLogRecord record;
+            record.level = static_cast<LogLevel>(copy.level);
+            record.time = std::chrono::system_clock::time_point(
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                    std::chrono::nanoseconds(copy.time_ns)));
+            record.tag.assign(copy.tag, copy.tag_len);
+            record.text.assign(copy.text, copy.text_len);
+            if (use_regex && !std::regex_search(record.text, re))
+                continue;
+
+            records.push_back(std::move(record));
+        }
+        return records;
+    }
+
+private:
+    // 槽位内容，读写时整体按 8 字节字复制
+    struct Payload
+    {
+        int64_t time_ns;
+        uint8_t level;
+        uint8_t tag_len;
+        uint16_t text_len;
+        char tag[28];
+        char text[kSlotSize - 48];
+    };
+
+    static constexpr size_t kWords = sizeof(Payload) / sizeof(uint64_t);
+    static constexpr size_t kTextOffset = offsetof(Payload, text);
+
+    struct Slot
+    {
+        std::atomic<uint64_t> seq; // 2 * 序号 + 2 表示写入完成，奇数表示正在写入
+        std::atomic<uint64_t> words[kWords];
+
+        Slot() : seq(0)
+        {
+            for (auto &word : words)
+                word.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    static_assert(sizeof(Payload) % sizeof(uint64_t) == 0, "unexpected payload size");
+    static_assert(sizeof(Slot) == kSlotSize, "unexpected slot size");
+
+    // 写入 payload 的前 bytes 字节（向上取整到字）
+    static void storeWords(Slot &slot, const Payload &payload, size_t bytes)
+    {
+        const char *src = reinterpret_cast<const char *>(&payload);
+        size_t end = (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+        for (size_t i = 0; i < end; ++i)
+        {
+            uint64_t word;
+            std::memcpy(&word, src + i * sizeof(uint64_t), sizeof(word));
+            slot.words[i].store(word, std::memory_order_relaxed);
+        }
+    }
+
+    // 读取 [begin, end) 字节（begin 按字对齐，end 向上取整到字）
+    static void loadWords(const Slot &slot, Payload &payload, size_t begin, size_t end)
+    {
+        char *dst = reinterpret_cast<char *>(&payload);
+        size_t last = (end + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+        for (size_t i = begin / sizeof(uint64_t); i < last; ++i)
+        {
+            uint64_t word = slot.words[i].load(std::memory_order_relaxed);
+            std::memcpy(dst + i * sizeof(uint64_t), &word, sizeof(word));
+        }
+    }
+
+    std::unique_ptr<Slot[]> slots_;
+    uint64_t mask_;
+    std::atomic<uint64_t> head_; // 下一条日志的序号
+};
+
+#ifndef _WIN32
+// ======================
+// 内存日志查询服务 (Unix 域套接字)
+// ======================
+// 每个连接发送一行查询条件，服务端返回匹配的日志后关闭连接，例如：
+//   echo "level=WARN tag=DATABASE regex=timeout" | nc -U /tmp/app.log.sock
+// regex= 必须放在最后，其后整行内容都作为正则表达式。
+// 套接字文件权限为 0600，只有运行日志进程的用户可以查询。
+// 连接按顺序处理：客户端 5 秒内没有读完结果时连接被关闭，stop() 最多等待约 100 毫秒。
+class MemoryQueryServer
+{
+public:
+    typedef std::function<std::vector<MemoryLogRecord>(const LogFilter &)> QueryFunc;
+
+    explicit MemoryQueryServer(QueryFunc query)
+        : query_(std::move(query)), listen_fd_(-1), stop_(false)
+    {
+    }
+
+    ~MemoryQueryServer()
+    {
+        stop();
+    }
+
+    // 在 socket_path 上开始监听，路径已存在且不是套接字时返回 false
+    bool start(const std::string &socket_path)
+    {
+        struct sockaddr_un addr;
+        if (socket_path.empty() || socket_path.size() >= sizeof(addr.sun_path))
+            return false;
+
+        // 只清理上次遗留的套接字文件，不删除同名的普通文件
+        struct stat st;
+        if (::lstat(socket_path.c_str(), &st) == 0)
+        {
+            if (!S_ISSOCK(st.st_mode))
+                return false;
+            ::unlink(socket_path.c_str());
+        }
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            return false;
+
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, socket_path.c_str(), socket_path.size());
+        if (::bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        // 在 listen 之前收紧权限，其他用户无法连接读取日志
+        if (::chmod(socket_path.c_str(), S_IRUSR | S_IWUSR) != 0 || ::listen(fd, 8) != 0)
+        {
+            ::close(fd);
+            ::unlink(socket_path.c_str());
+            return false;
+        }
+
+        listen_fd_ = fd;
+        socket_path_ = socket_path;
+        stop_ = false;
+        thread_ = std::thread(&MemoryQueryServer::serveLoop, this);
+        return true;
+    }
+
+    // 停止服务并删除套接字文件
+    void stop()
+    {
+        if (!thread_.joinable())
+            return;
+        stop_ = true;
+        thread_.join();
+        ::close(listen_fd_);
+        ::unlink(socket_path_.c_str());
+        listen_fd_ = -1;
+    }
+
+private:
+    void serveLoop()
+    {
+        while (!stop_)
+        {
+            struct pollfd pfd;
+            pfd.fd = listen_fd_;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if (::poll(&pfd, 1, 200) <= 0)
+                continue;
+
+            int client = ::accept(listen_fd_, nullptr, nullptr);
+            if (client < 0)
+                continue;
+            handleClient(client);
+            ::close(client);
+        }
+    }
+
+    // 等待客户端套接字可读或可写。每 100 毫秒检查一次 stop_，
+    // 服务停止、超过截止时间或连接出错时返回 false
+    bool waitClient(int client, short events, std::chrono::steady_clock::time_point deadline) const
+    {
+        while (!stop_)
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+                return false;
+            int timeout_ms = static_cast<int>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()) + 1;
+            if (timeout_ms > 100)
+                timeout_ms = 100;
+
+            struct pollfd pfd;
+            pfd.fd = client;
+            pfd.events = events;
+            pfd.revents = 0;
+            int ready = ::poll(&pfd, 1, timeout_ms);
+            if (ready < 0 && errno != EINTR)
+                return false;
+            if (ready > 0)
+                return (pfd.revents & (POLLERR | POLLNVAL)) == 0;
+        }
+        return false;
+    }
+
+    void handleClient(int client)
+    {
+        // 客户端套接字设为非阻塞，不读取结果的客户端不会让 stop() 无限等待
+        int flags = ::fcntl(client, F_GETFL, 0);
+        if (flags < 0 || ::fcntl(client, F_SETFL, flags | O_NONBLOCK) != 0)
+            return;
+
+        // 读取一行查询条件，最多等待 1 秒
+        std::string request;
+        char buffer[512];
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (request.find('\n') == std::string::npos && request.size() < 4096)
+        {
+            if (!waitClient(client, POLLIN, deadline))
+                break;
+            ssize_t n = ::read(client, buffer, sizeof(buffer));
+            if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+                continue;
+            if (n <= 0)
+                break;
+            request.append(buffer, static_cast<size_t>(n));
+        }
+        if (stop_)
+            return;
+        request = request.substr(0, request.find_first_of("\r\n"));
+
+        std::string response;
+        for (const auto &record : query_(parseFilter(request)))
+        {
+            response += record.text;
+            response += '\n';
+        }
+
+        // 发送结果，整个响应最多等待 5 秒
+        size_t sent = 0;
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (sent < response.size())
+        {
+            if (!waitClient(client, POLLOUT, deadline))
+                break;
+#ifdef MSG_NOSIGNAL
+            ssize_t n = ::send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+#else
+            ssize_t n = ::send(client, response.data() + sent, response.size() - sent, 0);
+#endif
+            if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+                continue;
+            if (n <= 0)
+                break;
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    // 解析 "level=WARN tag=DATABASE regex=..." 形式的查询条件
+    static LogFilter parseFilter(const std::string &request)
+    {
+        static const char *const levels[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+
+        LogFilter filter;
+        std::istringstream iss(request);
+        std::string token;
+        while (iss >> token)
+        {
+            if (token.compare(0, 6, "regex=") == 0)
+            {
+                size_t pos = request.find("regex=");
+                filter.pattern = request.substr(pos + 6);
+                break;
+            }
+            if (token.compare(0, 4, "tag=") == 0)
+            {
+                filter.tag = token.substr(4);
+            }
+            else if (token.compare(0, 6, "level=") == 0)
+            {
+                std::string name = token.substr(6);
+                for (auto &c : name)
+                    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+                for (int i = 0; i < 6; ++i)
+                {
+                    if (name == levels[i])
+                        filter.min_level = static_cast<LogLevel>(i);
+                }
+            }
+        }
+        return filter;
+    }
+
+    QueryFunc query_;
+    int listen_fd_;
+    std::string socket_path_;
+    std::atomic<bool> stop_;
+    std::thread thread_;
+};
+#endif
+
+// ======================
+// 快速格式化
+// ======================
+// 覆盖 printf 最常用的说明符：%d %i %u %x %X %c %s %p %% 及 l/ll/z 长度修饰，
+// %f / %.Nf (N <= 17)。整数每次转换两位，浮点数按精确值做定点舍入（四舍六入五成双），
+// 输出与 glibc 逐字节一致。遇到宽度、标志等不支持的写法返回 false，由调用方改用 vsnprintf。
+class FastFormatter
+{
+public:
+    // 格式化并追加到 out，返回 false 时 out 保持不变且 args 未被消耗
+    static bool format(LogRecord &out, const char *format, va_list args)
+    {
+        size_t old_size = out.size();
+        va_list ap;
+        va_copy(ap, args);
+        bool ok = formatImpl(out, format, ap);
+        va_end(ap);
+        if (!ok)
+        {
+            out.resize(old_size);
+        }
+        return ok;
+    }
+
+    // 无符号整数转十进制，每次处理两位
+    static void appendDecimal(LogRecord &out, unsigned long long value)
+    {
+        static const char digits[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+
+        char buffer[24];
+        char *end = buffer + sizeof(buffer);
+        char *pos = end;
+        while (value >= 100)
+        {
+            unsigned index = static_cast<unsigned>(value % 100) * 2;
+            value /= 100;
+            *--pos = digits[index + 1];
+            *--pos = digits[index];
+        }
+        if (value >= 10)
+        {
+            unsigned index = static_cast<unsigned>(value) * 2;
+            *--pos = digits[index + 1];
+            *--pos = digits[index];
+        }
+        else
+        {
+            *--pos = static_cast<char>('0' + value);
+        }
+        out.append(pos, end - pos);
+    }
+
+private:
+    static bool formatImpl(LogRecord &out, const char *format, va_list ap)
+    {
+        const char *p = format;
+        while (*p)
+        {
+            // 普通字符整段追加
+            const char *percent = std::strchr(p, '%');
+            if (!percent)
+            {
+                out += p;
+                break;
+            }
+            out.append(p, percent - p);
+            p = percent + 1;
+
+            if (*p == '%')
+            {
+                out += '%';
+                ++p;
+                continue;
+            }
+
+            // 精度（只用于 %f）
+            int precision = -1;
+            if (*p == '.')
+            {
+                ++p;
+                precision = 0;
+                while (*p >= '0' && *p <= '9')
+                {
+                    precision = precision * 10 + (*p - '0');
+                    if (precision > 17)
+                        return false;
+                    ++p;
+                }
+            }
+
+            // 长度修饰
+            int length = 0; // 0: int, 1: long, 2: long long, 3: size_t
+            if (*p == 'l')
+            {
+                length = 1;
+                ++p;
+                if (*p == 'l')
+                {
+                    length = 2;
+                    ++p;
+                }
+            }
+            else if (*p == 'z')
+            {
+                length = 3;
+                ++p;
+            }
+
+            char conv = *p++;
+            if (precision >= 0 && conv != 'f')
+                return false;
+
+            switch (conv)
+            {
+            case 'd':
+            case 'i':
+            {
+                long long value = length == 0   ? va_arg(ap, int)
+                                  : length == 1 ? va_arg(ap, long)
+                                  : length == 2 ? va_arg(ap, long long)
+                                                : static_cast<long long>(va_arg(ap, ptrdiff_t));
+                unsigned long long magnitude = static_cast<unsigned long long>(value);
+                if (value < 0)
+                {
+                    out += '-';
+                    magnitude = 0ULL - magnitude;
+                }
+                appendDecimal(out, magnitude);
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X':
+            {
+                unsigned long long value = length == 0   ? va_arg(ap, unsigned int)
+                                           : length == 1 ? va_arg(ap, unsigned long)
+                                           : length == 2 ? va_arg(ap, unsigned long long)
+                                                         : va_arg(ap, size_t);
+                if (conv == 'u')
+                    appendDecimal(out, value);
+                else
+                    appendHex(out, value, conv == 'X');
+                break;
+            }
+            case 'c':
+                if (length != 0)
+                    return false;
+                out += static_cast<char>(va_arg(ap, int));
+                break;
+            case 's':
+            {
+                if (length != 0)
+                    return false;
+                const char *str = va_arg(ap, const char *);
+                out += str ? str : "(null)";
+                break;
+            }
+            case 'p':
+            {
+                if (length != 0)
+                    return false;
+                const void *ptr = va_arg(ap, const void *);
+                if (!ptr)
+                {
+                    out += "(nil)";
+                }
+                else
+                {
+                    out += "0x";
+                    appendHex(out, reinterpret_cast<uintptr_t>(ptr), false);
+                }
+                break;
+            }
+            case 'f':
+                if (length > 1 || !appendFixed(out, va_arg(ap, double), precision < 0 ? 6 : precision))
+                    return false;
+                break;
+            default:
+                return false; // 不支持的说明符、宽度或标志
+            }
+        }
+        return true;
+    }
+
+    // 无符号整数转十六进制
+    static void appendHex(LogRecord &out, unsigned long long value, bool upper)
+    {
+        const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+        char buffer[16];
+        char *end = buffer + sizeof(buffer);
+        char *pos = end;
+        do
+        {
+            *--pos = digits[value & 0xf];
+            value >>= 4;
+        } while (value);
+        out.append(pos, end - pos);
+    }
+
+    // 定点格式输出 double：value = m * 2^e，计算 round(m * 10^p * 2^e)（五成双），
+    // 结果超出 64 位或为 inf/nan 时返回 false
+    static bool appendFixed(LogRecord &out, double value, int precision)
+    {
+#ifdef __SIZEOF_INT128__
+        typedef unsigned __int128 uint128;
+        static const uint64_t pow10[] = {
+            1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+            100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+            10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+            100000000000000000ULL};
+
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        bool negative = (bits >> 63) != 0;
+        int exponent = static_cast<int>((bits >> 52) & 0x7ff);
+        uint64_t mantissa = bits & ((1ULL << 52) - 1);
+        if (exponent == 0x7ff)
+            return false; // inf / nan
+
+        int shift; // value = mantissa * 2^shift
+        if (exponent == 0)
+        {
+            shift = -1074;
+        }
+        else
+        {
+            mantissa |= 1ULL << 52;
+            shift = exponent - 1075;
+        }
+
+        uint128 scaled = static_cast<uint128>(mantissa) * pow10[precision];
+        uint128 rounded;
+        if (shift >= 0)
+        {
+            if (shift >= 64 || (scaled >> (64 - shift)) != 0)
+                return false;
+            rounded = scaled << shift;
+        }
+        else if (-shift >= 128)
+        {
+            rounded = 0; // 远小于 0.5 个最小单位
+        }
+        else
+        {
+            int right = -shift;
+            rounded = scaled >> right;
+            uint128 remainder = scaled - (rounded << right);
+            uint128 half = static_cast<uint128>(1) << (right - 1);
+            if (remainder > half || (remainder == half && (rounded & 1)))
+            {
+                ++rounded;
+            }
+        }
+        if ((rounded >> 64) != 0)
+            return false;
+
+        uint64_t fixed = static_cast<uint64_t>(rounded);
+        if (negative)
+            out += '-';
+        appendDecimal(out, fixed / pow10[precision]);
+        if (precision > 0)
+        {
+            out += '.';
+            char buffer[20];
+            uint64_t fraction = fixed % pow10[precision];
+            for (int i = precision - 1; i >= 0; --i)
+            {
+                buffer[i] = static_cast<char>('0' + fraction % 10);
+                fraction /= 10;
+            }
+            out.append(buffer, precision);
+        }
+        return true;
+#else
+        (void)out;
+        (void)value;
+        (void)precision;
+        return false;
+#endif
+    }
+};
+
+// ======================
+// 文件刷新策略
+// ======================
+enum class FlushMode
+{
+    IMMEDIATE = 0, // 每次写入后立即刷新 (默认)
+    ADAPTIVE       // 根据日志速率自适应刷新
+};
+
+struct FlushPolicy
+{
+    FlushMode mode = FlushMode::IMMEDIATE;        // 刷新模式
+    double busy_rate = 1000.0;                    // 高于该速率（条/秒）时合并刷新
+    std::chrono::milliseconds max_staleness{100}; // 合并刷新时数据在缓冲区中的最长停留时间
+};
+
+// ======================
+// 文件输出
+// ======================
+// 日志文件及其互斥锁，写文件只锁这一把锁，不影响 Logger 的配置锁。
+// 自适应刷新时在写入路径上用 EWMA 估计每条日志的平均间隔：空闲时每次写入后立即刷新，
+// 速率超过 busy_rate 后只在数据停留超过 max_staleness 时刷新，之后不再有写入的数据
+// 由后台刷新线程按时刷新；Error/Fatal 日志总是立即刷新。
+class FileSink
+{
+public:
+    FileSink()
+        : open_(false), busy_interval_ns_(0), interval_ewma_ns_(0), dirty_(false), flusher_stop_(false)
+    {
+    }
+
+    ~FileSink()
+    {
+        stop();
+    }
+
+    // 打开文件（先关闭当前文件）
+    bool open(const std::string &file_path, bool append)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stream_.reset();
+        open_ = false;
+
+        auto mode = std::ios::out | std::ios::ate;
+        if (append)
+        {
+            mode |= std::ios::app;
+        }
+
+        auto new_file = std::unique_ptr<std::ofstream>(new std::ofstream(file_path, mode));
+        if (!new_file->is_open())
+        {
+            return false;
+        }
+
+        stream_ = std::move(new_file);
+        path_ = file_path;
+        open_ = true;
+        return true;
+    }
+
+    // 关闭文件
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stream_)
+        {
+            stream_->flush();
+        }
+        stream_.reset();
+        path_.clear();
+        open_ = false;
+        dirty_ = false;
+    }
+
+    // 是否已打开（无锁）
+    bool isOpen() const
+    {
+        return open_.load(std::memory_order_acquire);
+    }
+
+    // 当前文件路径
+    std::string path() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return path_;
+    }
+
+    // 写出一段连续数据（包含 records 条日志），按刷新策略决定是否刷新，
+    // urgent 表示其中有 Error/Fatal 日志
+    void write(const char *data, size_t size, size_t records = 1, bool urgent = false)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stream_)
+            return;
+        stream_->write(data, size);
+
+        if (policy_.mode == FlushMode::IMMEDIATE)
+        {
+            stream_->flush();
+            return;
+        }
+
+        // 每条日志平均间隔的 EWMA（权重 1/8）
+        auto now = std::chrono::steady_clock::now();
+        int64_t interval = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_write_).count() /
+                           static_cast<int64_t>(records ? records : 1);
+        interval_ewma_ns_ += (interval - interval_ewma_ns_) / 8;
+        last_write_ = now;
+
+        bool was_dirty = dirty_;
+        if (!dirty_)
+        {
+            dirty_ = true;
+            dirty_since_ = now;
+        }
+        if (urgent || interval_ewma_ns_ >= busy_interval_ns_ || now - dirty_since_ >= policy_.max_staleness)
+        {
+            flushLocked();
+        }
+        else if (!was_dirty)
+        {
+            flusher_cv_.notify_one(); // 由后台线程在 max_staleness 后刷新
+        }
+    }
+
+    // 刷新文件缓冲区
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flushLocked();
+    }
+
+    // 设置刷新策略，自适应模式下启动后台刷新线程
+    void setFlushPolicy(const FlushPolicy &policy)
+    {
+        stopFlusher();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        policy_ = policy;
+        if (policy_.max_staleness.count() <= 0)
+            policy_.max_staleness = std::chrono::milliseconds(1);
+        busy_interval_ns_ = policy_.busy_rate > 0 ? static_cast<int64_t>(1e9 / policy_.busy_rate) : 0;
+        interval_ewma_ns_ = busy_interval_ns_; // 从空闲与繁忙的分界开始估计
+        last_write_ = std::chrono::steady_clock::now();
+        flushLocked();
+
+        if (policy_.mode == FlushMode::ADAPTIVE)
+        {
+            flusher_stop_ = false;
+            flusher_ = std::thread(&FileSink::flushLoop, this);
+        }
+    }
+
+    // 停止后台刷新线程并关闭文件
+    void stop()
+    {
+        stopFlusher();
+        close();
+    }
+
+private:
+    void flushLocked()
+    {
+        if (stream_)
+        {
+            stream_->flush();
+        }
+        dirty_ = false;
+    }
+
+    void stopFlusher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            flusher_stop_ = true;
+        }
+        flusher_cv_.notify_all();
+        if (flusher_.joinable())
+            flusher_.join();
+    }
+
+    // 后台刷新：保证合并刷新时数据停留不超过 max_staleness
+    void flushLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!flusher_stop_)
+        {
+            if (!dirty_)
+            {
+                flusher_cv_.wait(lock);
+                continue;
+            }
+            flusher_cv_.wait_until(lock, dirty_since_ + policy_.max_staleness);
+            if (dirty_ && std::chrono::steady_clock::now() - dirty_since_ >= policy_.max_staleness)
+            {
+                flushLocked();
+            }
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::unique_ptr<std::ofstream> stream_; // 文件输出流
+    std::string path_;                      // 当前日志文件路径
+    std::atomic<bool> open_;
+
+    FlushPolicy policy_;                                 // 刷新策略
+    int64_t busy_interval_ns_;                           // busy_rate 对应的日志间隔
+    int64_t interval_ewma_ns_;                           // 日志间隔的 EWMA
+    std::chrono::steady_clock::time_point last_write_;   // 上次写入时间
+    bool dirty_;                                         // 是否有未刷新的数据
+    std::chrono::steady_clock::time_point dirty_since_;  // 最早未刷新数据的写入时间
+    bool flusher_stop_;
+    std::condition_variable flusher_cv_;
+    std::thread flusher_;                                // 后台刷新线程
+};
+
+// ======================
+// 异步文件写出配置
+// ======================
+struct AsyncWriterOptions
+{
+    size_t buffer_bytes = 4 << 20; // 每个缓冲区的容量（字节）
+    bool per_node = true;          // 是否每个 NUMA 节点一个缓冲区和写出线程
+    std::vector<int> cpus;         // 写出线程可运行的 CPU（为空时使用所属节点的全部 CPU）
+};
+
+// ======================
+// NUMA 拓扑
+// ======================
+// 从 /sys/devices/system/node 读取节点与 CPU 的对应关系，无法读取时（非 Linux、
+// 容器内未挂载 sysfs 等）视为只有一个节点。
+class NumaTopology
+{
+public:
+    struct Node
+    {
+        int id;                // 节点编号，-1 表示未知
+        std::vector<int> cpus; // 属于该节点的 CPU
+    };
+
+    static std::vector<Node> nodes()
+    {
+        std::vector<Node> result;
+#ifdef __linux__
+        for (int id : parseCpuList(readFile("/sys/devices/system/node/online")))
+        {
+            Node node;
+            node.id = id;
+            node.cpus = parseCpuList(readFile("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist"));
+            if (!node.cpus.empty())
+            {
+                result.push_back(node);
+            }
+        }
+#endif
+        if (result.empty())
+        {
+            Node node;
+            node.id = -1;
+            unsigned count = std::thread::hardware_concurrency();
+            for (unsigned cpu = 0; cpu < (count ? count : 1); ++cpu)
+            {
+                node.cpus.push_back(static_cast<int>(cpu));
+            }
+            result.push_back(node);
+        }
+        return result;
+    }
+
+    // 当前线程所在的 CPU，未知时返回 -1
+    static int currentCpu()
+    {
+#ifdef __linux__
+        return sched_getcpu();
+#else
+        return -1;
+#endif
+    }
+
+    // 把当前线程绑定到指定 CPU，失败时保持原样
+    static void pinCurrentThread(const std::vector<int> &cpus)
+    {
+#ifdef __linux__
+        if (cpus.empty())
+            return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus)
+        {
+            if (cpu >= 0 && cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &set);
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)cpus;
+#endif
+    }
+
+    // 在指定节点上分配内存（mbind 首选该节点），失败时退化为普通匿名映射
+    static char *allocate(size_t size, int node)
+    {
+#ifdef __linux__
+        void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED)
+            return nullptr;
+#ifdef SYS_mbind
+        if (node >= 0 && node < 1024)
+        {
+            const int mpol_preferred = 1;
+            unsigned long mask[1024 / (8 * sizeof(unsigned long))] = {};
+            mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+            syscall(SYS_mbind, addr, size, mpol_preferred, mask, 1024UL, 0U);
+        }
+#endif
+        return static_cast<char *>(addr);
+#else
+        (void)node;
+        return new char[size];
+#endif
+    }
+
+    static void deallocate(char *data, size_t size)
+    {
+#ifdef __linux__
+        munmap(data, size);
+#else
+        (void)size;
+        delete[] data;
+#endif
+    }
+
+private:
+    static std::string readFile(const std::string &path)
+    {
+        std::ifstream in(path);
+        std::string content;
+        std::getline(in, content);
+        return content;
+    }
+
+    // 解析 "0-3,8-11" 形式的列表
+    static std::vector<int> parseCpuList(const std::string &text)
+    {
+        std::vector<int> result;
+        std::istringstream iss(text);
+        std::string range;
+        while (std::getline(iss, range, ','))
+        {
+            int first = 0, last = 0;
+            if (std::sscanf(range.c_str(), "%d-%d", &first, &last) == 2)
+            {
+                for (int cpu = first; cpu <= last; ++cpu)
+                    result.push_back(cpu);
+            }
+            else if (std::sscanf(range.c_str(), "%d", &first) == 1)
+            {
+                result.push_back(first);
+            }
+        }
+        return result;
+    }
+};
+
+// ======================
+// 异步文件写出
+// ======================
+// 每个 NUMA 节点一个日志队列和一个绑定在该节点 CPU 上的写出线程，日志线程按第一次
+// 记录日志时所在的 CPU 选择本节点的队列并一直使用它（线程之后迁移到其他节点也不换队列，
+// 否则同一线程的日志会分散到两个队列中而乱序），只把记录指针挂到队尾；写出线程把整批记录合并到分配在本节点上
+// 的暂存缓冲区后一次写出，避免跨节点的缓存行传输。队列按字节数限流，已满时日志线程
+// 等待写出线程腾出空间，不丢日志；不同节点的日志在文件中可能交错。
+class AsyncFileWriter
+{
+public:
+    AsyncFileWriter(FileSink &sink, const AsyncWriterOptions &options)
+        : sink_(sink), id_(nextId())
+    {
+        std::vector<NumaTopology::Node> nodes = NumaTopology::nodes();
+        if (!options.per_node && nodes.size() > 1)
+        {
+            NumaTopology::Node all;
+            all.id = -1;
+            for (const auto &node : nodes)
+                all.cpus.insert(all.cpus.end(), node.cpus.begin(), node.cpus.end());
+            nodes.assign(1, all);
+        }
+
+        size_t capacity = options.buffer_bytes < 4096 ? 4096 : options.buffer_bytes;
+        for (const auto &node : nodes)
+        {
+            std::unique_ptr<NodeQueue> queue(new NodeQueue());
+            queue->node = node.id;
+            queue->capacity = capacity;
+
+            // 写出线程绑定到配置的 CPU 中属于本节点的部分，没有交集时使用全部配置的 CPU
+            for (int cpu : options.cpus)
+            {
+                if (std::find(node.cpus.begin(), node.cpus.end(), cpu) != node.cpus.end())
+                    queue->cpus.push_back(cpu);
+            }
+            if (queue->cpus.empty())
+                queue->cpus = options.cpus.empty() ? node.cpus : options.cpus;
+
+            for (int cpu : node.cpus)
+            {
+                if (cpu >= static_cast<int>(cpu_to_queue_.size()))
+                    cpu_to_queue_.resize(cpu + 1, 0);
+                cpu_to_queue_[cpu] = queues_.size();
+            }
+            queues_.push_back(std::move(queue));
+        }
+    }
+
+    ~AsyncFileWriter()
+    {
+        stop();
+    }
+
+    // 启动写出线程，等待各节点暂存缓冲区分配完成
+    void start()
+    {
+        for (auto &queue : queues_)
+        {
+            NodeQueue *q = queue.get();
+            q->thread = std::thread(&AsyncFileWriter::drainLoop, this, q);
+
+            std::unique_lock<std::mutex> lock(q->mutex);
+            q->not_full.wait(lock, [q]
+                             { return q->ready; });
+        }
+    }
+
+    // 写出剩余日志并停止写出线程
+    void stop()
+    {
+        for (auto &queue : queues_)
+        {
+            {
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                queue->stop = true;
+            }
+            queue->not_empty.notify_all();
+            queue->not_full.notify_all();
+        }
+        for (auto &queue : queues_)
+        {
+            if (queue->thread.joinable())
+                queue->thread.join();
+        }
+    }
+
+    // 放入一条完整的日志记录（可包含多行），队列持有记录的一个引用。
+    // 超过暂存缓冲区容量的记录等队列写空后单独入队，保持与之前日志的顺序
+    void push(LogRecord *record)
+    {
+        NodeQueue &q = localQueue();
+        const size_t size = record->size();
+        {
+            std::unique_lock<std::mutex> lock(q.mutex);
+            // 停止后等写出线程写完队列中的日志再直接写文件，同样保持顺序
+            q.not_full.wait(lock, [&q, size]
+                            { return q.pending_bytes == 0 || (!q.stop && q.pending_bytes + size <= q.capacity); });
+            if (q.stop)
+            {
+                lock.unlock();
+                sink_.write(record->data(), size, 1, record->level >= LogLevel::Error);
+                return;
+            }
+
+            record->addRef();
+            record->next[LogRecord::kFileLink] = nullptr;
+            if (q.tail)
+                q.tail->next[LogRecord::kFileLink] = record;
+            else
+                q.head = record;
+            q.tail = record;
+            q.pending_bytes += size;
+        }
+        q.not_empty.notify_one();
+    }
+
+    // 等待所有队列写空，最多等待 timeout
+    bool flush(std::chrono::milliseconds timeout)
+    {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        bool drained = true;
+        for (auto &queue : queues_)
+        {
+            NodeQueue *q = queue.get();
+            std::unique_lock<std::mutex> lock(q->mutex);
+            drained = q->not_full.wait_until(lock, deadline, [q]
+                                             { return q->pending_bytes == 0; }) &&
+                      drained;
+        }
+        return drained;
+    }
+
+private:
+    struct NodeQueue
+    {
+        int node = -1;              // NUMA 节点编号
+        std::vector<int> cpus;      // 写出线程绑定的 CPU
+        size_t capacity = 0;        // 暂存缓冲区容量，也是队列的字节上限（队列为空时可放入一条更大的记录）
+        size_t pending_bytes = 0;   // 队列中和正在写出的字节数
+        LogRecord *head = nullptr;  // 待写出队列
+        LogRecord *tail = nullptr;
+        bool ready = false;         // 暂存缓冲区是否已分配
+        bool stop = false;          // 是否停止
+        std::mutex mutex;
+        std::condition_variable not_empty; // 有新日志
+        std::condition_variable not_full;  // 已写出一部分（或暂存缓冲区已就绪）
+        std::thread thread;
+    };
+
+    // 按当前 CPU 选择本节点的队列
+    // 当前线程使用的队列，第一次调用时按所在 CPU 选定
+    NodeQueue &localQueue()
+    {
+        if (queues_.size() == 1)
+            return *queues_[0];
+
+        // 按写出器编号区分，重新创建写出器后重新选择
+        struct Choice
+        {
+            uint64_t writer_id;
+            size_t index;
+        };
+        static thread_local Choice choice = {0, 0};
+        if (choice.writer_id != id_)
+        {
+            int cpu = NumaTopology::currentCpu();
+            choice.index = cpu >= 0 && cpu < static_cast<int>(cpu_to_queue_.size()) ? cpu_to_queue_[cpu] : 0;
+            choice.writer_id = id_;
+        }
+        return *queues_[choice.index];
+    }
+
+    static uint64_t nextId()
+    {
+        static std::atomic<uint64_t> next(1);
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void drainLoop(NodeQueue *q)
+    {
+        // 先绑定 CPU 再分配并触碰内存，mbind 不可用时由首次访问把页面放在本节点
+        NumaTopology::pinCurrentThread(q->cpus);
+        char *data = NumaTopology::allocate(q->capacity, q->node);
+        bool mapped = data != nullptr;
+        if (!mapped)
+        {
+            data = new char[q->capacity];
+        }
+        std::memset(data, 0, q->capacity);
+        {
+            std::lock_guard<std::mutex> lock(q->mutex);
+            q->ready = true;
+        }
+        q->not_full.notify_all();
+
+        for (;;)
+        {
+            LogRecord *batch;
+            size_t size;
+            {
+                std::unique_lock<std::mutex> lock(q->mutex);
+                q->not_empty.wait(lock, [q]
+                                  { return q->stop || q->head != nullptr; });
+                if (!q->head)
+                    break; // 已停止且没有剩余日志
+                batch = q->head;
+                q->head = q->tail = nullptr;
+                size = q->pending_bytes;
+            }
+
+            // 合并到暂存缓冲区后一次写出，写文件时无需持有队列锁；
+            // 超过暂存缓冲区容量的记录先写出已合并的部分，再直接写出该记录
+            size_t offset = 0;
+            size_t records = 0;
+            bool urgent = false;
+            while (batch)
+            {
+                LogRecord *next = batch->next[LogRecord::kFileLink];
+                if (offset + batch->size() > q->capacity && offset > 0)
+                {
+                    sink_.write(data, offset, records, urgent);
+                    offset = 0;
+                    records = 0;
+                    urgent = false;
+                }
+                if (batch->size() > q->capacity)
+                {
+                    sink_.write(batch->data(), batch->size(), 1, batch->level >= LogLevel::Error);
+                }
+                else
+                {
+                    std::memcpy(data + offset, batch->data(), batch->size());
+                    offset += batch->size();
+                    records++;
+                    urgent = urgent || batch->level >= LogLevel::Error;
+                }
+                RecordPool::release(batch);
+                batch = next;
+            }
+            if (offset > 0)
+            {
+                sink_.write(data, offset, records, urgent);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(q->mutex);
+                q->pending_bytes -= size;
+            }
+            q->not_full.notify_all();
+        }
+
+        if (mapped)
+            NumaTopology::deallocate(data, q->capacity);
+        else
+            delete[] data;
+    }
+
+    FileSink &sink_;
+    const uint64_t id_; // 写出器编号，用于线程缓存的队列选择
+    std::vector<std::unique_ptr<NodeQueue>> queues_;
+    std::vector<size_t> cpu_to_queue_; // CPU 编号 -> 队列下标
+};
+
+// ======================
+// 标签运行时状态
+// ======================
+// 每个标签第一次出现时创建一份，之后不再释放。配置变更时在配置锁内更新，
+// 日志线程无锁读取，过滤、着色和路由都不需要查找 map。
+struct TagState
+{
+    std::string name;                 // 标签名
+    uint64_t hash;                    // 标签名的哈希
+    std::atomic<bool> enabled;        // 是否启用
+    std::atomic<bool> has_level;      // 是否设置了标签级别
+    std::atomic<LogLevel> level;      // 标签级别
+    std::atomic<const char *> color;  // 标签文本颜色
+    std::atomic<const char *> style;  // 标签文本样式
+    std::atomic<FileSink *> sink;     // 路由目标（为空时写入主日志文件）
+    bool published;                   // 是否已发布到无锁哈希表（需持有 Logger 的锁）
+
+    explicit TagState(const std::string &tag_name)
+        : name(tag_name), hash(hashName(tag_name.c_str())), enabled(true), has_level(false), level(LogLevel::Info),
+          color(ansi::cyan), style(""), sink(nullptr), published(false)
+    {
+    }
+
+    // FNV-1a 哈希
+    static uint64_t hashName(const char *tag_name)
+    {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (const unsigned char *p = reinterpret_cast<const unsigned char *>(tag_name); *p; ++p)
+        {
+            hash ^= *p;
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+};
+
+// ======================
+// 日志调用点
+// ======================
+// 日志宏检查一次等级和标签后把结果保存在这里，记录时直接使用，不再重复过滤
+struct LogSite
+{
+    LogLevel level = LogLevel::OFF;     // 日志等级
+    const char *tag = nullptr;          // 标签（可为 nullptr）
+    TagState *state = nullptr;          // 标签状态
+    MemoryRingBuffer *memory = nullptr; // 需要写入的内存缓冲区
+    bool to_outputs = false;            // 是否输出到控制台和文件
+};
+
+class Logger;
+
+// ======================
+// 批量日志
+// ======================
+// 由 Logger::batch() 创建，整批共用一个时间戳和过滤结果，add() 把各行格式化到
+// 同一条日志记录中，commit()（或析构时）一次加锁、一次写出。
+class LogBatch
+{
+public:
+    LogBatch()
+        : logger_(nullptr), level_(LogLevel::OFF), tag_state_(nullptr), to_outputs_(false), memory_(nullptr),
+          line_color_(false), prefix_(nullptr), record_(nullptr), lines_(0)
+    {
+    }
+
+    LogBatch(LogBatch &&other)
+        : logger_(other.logger_),
+          level_(other.level_),
+          tag_(std::move(other.tag_)),
+          tag_state_(other.tag_state_),
+          to_outputs_(other.to_outputs_),
+          memory_(other.memory_),
+          line_color_(other.line_color_),
+          prefix_(other.prefix_),
+          record_(other.record_),
+          lines_(other.lines_)
+    {
+        other.logger_ = nullptr;
+        other.prefix_ = nullptr;
+        other.record_ = nullptr;
+        other.lines_ = 0;
+    }
+
+    ~LogBatch()
+    {
+        commit();
+        if (prefix_)
+            RecordPool::release(prefix_);
+    }
 
-    TagConfig() {}
+    // 添加一行日志 (printf 风格)
+    LogBatch &add(const char *format, ...);
 
-    TagConfig(const char *_color, const char *_style, bool _enabled)
-        : color(_color), style(_style), enabled(_enabled)
+    // 写出已添加的日志，之后可继续添加
+    void commit();
+
+    // 是否会被记录（被过滤时 add 不做任何格式化）
+    bool active() const
+    {
+        return logger_ != nullptr;
+    }
+
+    // 尚未写出的行数
+    size_t size() const
+    {
+        return lines_;
+    }
+
+private:
+    friend class Logger;
+
+    LogBatch(Logger *logger, LogLevel level, const char *tag, TagState *tag_state, bool to_outputs,
+             MemoryRingBuffer *memory)
+        : logger_(logger),
+          level_(level),
+          tag_(tag ? tag : ""),
+          tag_state_(tag_state),
+          to_outputs_(to_outputs),
+          memory_(memory),
+          line_color_(false),
+          prefix_(RecordPool::acquire()),
+          record_(nullptr),
+          lines_(0)
     {
     }
+
+    LogBatch(const LogBatch &) = delete;
+    LogBatch &operator=(const LogBatch &) = delete;
+
+    Logger *logger_;            // 为空表示该批日志被过滤
+    LogLevel level_;            // 日志等级
+    std::string tag_;           // 标签
+    TagState *tag_state_;       // 标签状态（无标签时为空）
+    bool to_outputs_;           // 是否写到控制台/文件
+    MemoryRingBuffer *memory_;  // 内存缓冲区（为空表示不写入）
+    bool line_color_;           // 是否整行着色
+    LogRecord *prefix_;         // 每行共用的前缀
+    LogRecord *record_;         // 已格式化的日志行（首次 add 时从池中取出）
+    size_t lines_;              // record_ 中的行数
 };
 
 // ======================
@@ -156,17 +2337,90 @@ class Logger
 {
 public:
     // 获取单例实例
+    // 实例用 placement new 构造在对齐的静态存储中且从不析构，其他静态对象析构时仍可
+    // 安全调用；进程退出时由 atexit/at_quick_exit 钩子调用 shutdown() 写出缓冲区中的日志
     static Logger &instance()
     {
-        static Logger instance;
-        return instance;
+        // 使用静态存储而非 new，保证 HotConfig 的缓存行对齐
+        static std::aligned_storage<sizeof(Logger), alignof(Logger)>::type storage;
+        static Logger *instance = new (&storage) Logger();
+        return *instance;
+    }
+
+    // 关闭日志系统：写出所有缓冲区、停止后台线程并关闭文件，最多等待 timeout。
+    // 之后的日志调用都是空操作。返回 false 表示超时导致部分日志未能写出
+    bool shutdown(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000))
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (hot_.shut_down.exchange(true))
+            return true;
+        LogGate::min_level.store(static_cast<int>(LogLevel::OFF), std::memory_order_relaxed);
+        std::lock_guard<std::mutex> output_lock(output_mutex_);
+
+        bool drained = true;
+#ifndef _WIN32
+        memory_server_.reset();
+#endif
+        if (console_sink_)
+        {
+            drained = console_sink_->stop(timeout);
+            console_sink_.reset();
+        }
+        if (hot_.console_output)
+        {
+            std::cerr.flush();
+        }
+        if (AsyncFileWriter *writer = file_writer_.load(std::memory_order_acquire))
+        {
+            writer->stop();
+        }
+        file_writer_.store(nullptr, std::memory_order_release);
+        file_sink_.stop();
+        for (auto &item : route_sinks_)
+        {
+            item.second->stop();
+        }
+        return drained;
+    }
+
+    // 是否已关闭
+    bool isShutdown() const
+    {
+        return hot_.shut_down.load(std::memory_order_acquire);
+    }
+
+    // 立即写出控制台和文件缓冲区中的日志，最多等待 timeout
+    bool flush(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000))
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        for (auto &item : route_sinks_)
+        {
+            item.second->flush();
+        }
+        std::lock_guard<std::mutex> output_lock(output_mutex_);
+        bool drained = true;
+        if (console_sink_)
+        {
+            drained = console_sink_->flush(timeout);
+        }
+        if (hot_.console_output)
+        {
+            std::cerr.flush();
+        }
+        if (AsyncFileWriter *writer = file_writer_.load(std::memory_order_acquire))
+        {
+            drained = writer->flush(timeout) && drained;
+        }
+        file_sink_.flush();
+        return drained;
     }
 
     // 设置全局日志级别
     void setLevel(LogLevel level)
     {
         std::lock_guard<std::recursive_mutex> lock(mutex_);
-        current_level_ = level;
+        hot_.current_level = level;
+        updateHotLevels();
     }
 
     // 设置标签日志级别
@@ -174,41 +2428,87 @@ public:
     {
         std::lock_guard<std::recursive_mutex> lock(mutex_);
         tag_levels_[tag] = level;
+        refreshTagState(tag);
+        updateHotLevels();
     }
 
     // 开启/禁用控制台输出
     void consoleOutput(const bool& console_output)
     {
         std::lock_guard<std::recursive_mutex> lock(mutex_);
-        console_output_ = console_output;
+        hot_.console_output = console_output;
     }
 
-    // 设置日志文件路径（自动管理文件）
-    bool setLogFile(const std::string &file_path, bool append = true)
+    // 启用/禁用异步控制台输出（非阻塞写 stderr，缓冲区满时优先丢弃低等级日志）
+    void setAsyncConsole(bool enabled, size_t buffer_bytes = 1 << 20)
     {
         std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (hot_.shut_down)
+            return;
+        std::lock_guard<std::mutex> output_lock(output_mutex_);
+        if (console_sink_)
+        {
+            console_sink_->stop();
+            console_sink_.reset();
+        }
+        if (enabled)
+        {
+            console_sink_.reset(new AsyncConsoleSink(buffer_bytes));
+            console_sink_->start();
+        }
+    }
 
-        try
+    // 启用/禁用异步文件写出：每个 NUMA 节点一个缓冲区和写出线程，写出线程可绑定到指定 CPU
+    void setAsyncWriter(bool enabled, const AsyncWriterOptions &options = AsyncWriterOptions())
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (hot_.shut_down)
+            return;
+
+        // 日志线程不加锁使用写出器，旧写出器只停止不释放。先停止（写完队列）再撤下，
+        // 停止期间和之后仍在使用它的日志线程等队列写空后直接写文件，不丢失也不乱序
+        if (AsyncFileWriter *writer = file_writer_.load(std::memory_order_acquire))
+        {
+            writer->stop();
+        }
+        file_writer_.store(nullptr, std::memory_order_release);
+        if (enabled)
         {
-            // 关闭当前文件（如果有）
-            file_output_.reset();
+            retired_writers_.emplace_back(new AsyncFileWriter(file_sink_, options));
+            retired_writers_.back()->start();
+            file_writer_.store(retired_writers_.back().get(), std::memory_order_release);
+        }
+    }
 
-            // 打开新文件
-            auto mode = std::ios::out | std::ios::ate;
-            if (append)
-            {
-                mode |= std::ios::app;
-            }
+    // 设置日志文件的刷新策略：默认每条日志后刷新；自适应模式下空闲时立即刷新，
+    // 繁忙时合并刷新，数据最多停留 max_staleness，Error/Fatal 总是立即刷新
+    void setFlushPolicy(const FlushPolicy &policy)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (hot_.shut_down)
+            return;
+        file_sink_.setFlushPolicy(policy);
+    }
 
-            auto new_file = std::unique_ptr<std::ofstream>(new std::ofstream(file_path, mode));
-            if (!new_file->is_open())
-            {
-                return false;
-            }
+    // 获取异步控制台输出的统计信息（未启用时全部为 0）
+    ConsoleSinkStats getConsoleStats() const
+    {
+        std::lock_guard<std::mutex> output_lock(output_mutex_);
+        return console_sink_ ? console_sink_->stats() : ConsoleSinkStats();
+    }
 
-            file_output_ = std::move(new_file);
-            file_path_ = file_path;
-            return true;
+    // 设置日志文件路径（自动管理文件）
+    bool setLogFile(const std::string &file_path, bool append = true)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (hot_.shut_down)
+            return false;
+
+        try
+        {
+            // 先写出异步缓冲区中属于当前文件的日志，再关闭当前文件并打开新文件
+            flushFileWriter();
+            return file_sink_.open(file_path, append);
         }
         catch (...)
         {
@@ -280,235 +2580,654 @@ public:
     void closeLogFile()
     {
         std::lock_guard<std::recursive_mutex> lock(mutex_);
-        file_output_.reset();
-        file_path_.clear();
+        flushFileWriter();
+        file_sink_.close();
     }
 
     // 配置标签显示
     void configureTag(const std::string &tag, const char *color, const char *style = "", bool enabled = true)
     {
         std::lock_guard<std::recursive_mutex> lock(mutex_);
-        tag_configs_[tag] = TagConfig(color, style, enabled);
+        TagConfig &config = tag_configs_[tag];
+        config.color = color;
+        config.style = style;
+        config.enabled = enabled;
+        refreshTagState(tag);
+        updateHotLevels();
     }
 
     // 启用/禁用特定标签
     void enableTag(const std::string &tag, bool enabled)
     {
         std::lock_guard<std::recursive_mutex> lock(mutex_);
-        if (tag_configs_.find(tag) != tag_configs_.end())
+        tag_configs_[tag].enabled = enabled;
+        refreshTagState(tag);
+        updateHotLevels();
+    }
+
+    // 把标签的日志路由到单独的文件（file_path 为空时恢复写入主日志文件）。
+    // 每个路由文件有独立的锁、缓冲区和刷新策略，不受异步文件写出的影响；
+    // 同一路径只打开一次，路由到同一文件的标签共用该文件及其刷新策略
+    bool routeTag(const std::string &tag, const std::string &file_path, bool append = true,
+                  const FlushPolicy &policy = FlushPolicy())
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (hot_.shut_down)
+            return false;
+
+        TagState *state = internTag(tag);
+        FileSink *new_sink = nullptr;
+        if (!file_path.empty())
         {
-            tag_configs_[tag].enabled = enabled;
+            // 路由文件按路径复用，只在 shutdown 时关闭，不释放，日志线程可无锁使用
+            auto it = route_sinks_.find(file_path);
+            if (it == route_sinks_.end())
+            {
+                std::unique_ptr<FileSink> sink(new FileSink());
+                if (!sink->open(file_path, append))
+                    return false;
+                it = route_sinks_.emplace(file_path, std::move(sink)).first;
+            }
+            it->second->setFlushPolicy(policy);
+            new_sink = it->second.get();
         }
-        else
+
+        // 旧的路由文件不在这里关闭：其他线程可能刚读到它的指针，仍在写入
+        FileSink *old_sink = state->sink.exchange(new_sink, std::memory_order_acq_rel);
+        if (old_sink && old_sink != new_sink)
         {
-            tag_configs_[tag] = TagConfig(ansi::cyan, "", enabled);
+            old_sink->flush();
         }
+        return true;
     }
 
     // 设置颜色模式
     void setColorMode(ColorMode color_mode)
     {
         std::lock_guard<std::recursive_mutex> lock(mutex_);
-        color_mode_ = color_mode;
+        hot_.color_mode = color_mode;
     }
 
     // 启用/禁用时间戳
     void enableTimestamp(bool enabled)
     {
         std::lock_guard<std::recursive_mutex> lock(mutex_);
-        show_timestamp_ = enabled;
+        hot_.show_timestamp = enabled;
     }
 
     // 设置时间戳精度
     void setTimestampPrecision(TimestampPrecision precision)
     {
         std::lock_guard<std::recursive_mutex> lock(mutex_);
-        timestamp_precision_ = precision;
+        hot_.timestamp_precision = precision;
+    }
+
+    // 启用/禁用快速格式化（常用说明符不经过 vsnprintf，输出与 glibc 一致）
+    void enableFastFormat(bool enabled)
+    {
+        hot_.fast_format.store(enabled, std::memory_order_relaxed);
     }
 
     // 设置位置信息显示模式
     void setLocationMode(LocationDisplayMode mode, const std::string &base_path = "")
     {
         std::lock_guard<std::recursive_mutex> lock(mutex_);
-        location_mode_ = mode;
+        hot_.location_mode = mode;
         base_path_ = base_path;
     }
 
-    // 启用/禁用标签显示
-    void enableTags(bool enabled)
-    {
-        std::lock_guard<std::recursive_mutex> lock(mutex_);
-        show_tags_ = enabled;
+    // 启用/禁用标签显示
+    void enableTags(bool enabled)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        hot_.show_tags = enabled;
+    }
+
+    // 获取当前日志文件路径
+    std::string getLogFilePath() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return file_sink_.path();
+    }
+
+    // 设置内存日志缓冲区（capacity_bytes 为 0 时关闭），level 为写入内存的最低等级，
+    // 可低于控制台/文件的日志等级，便于在不落盘的情况下保留最近的 Trace/Debug 日志
+    void setMemoryBuffer(size_t capacity_bytes, LogLevel level = LogLevel::Trace)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        hot_.memory_level = level;
+
+        MemoryRingBuffer *current = memory_ring_.load(std::memory_order_relaxed);
+        if (capacity_bytes == 0)
+        {
+            memory_ring_.store(nullptr, std::memory_order_release);
+        }
+        else if (!current || current->capacity() < capacity_bytes)
+        {
+            // 旧缓冲区可能仍在被无锁读写，保留到进程结束，不释放
+            retired_rings_.emplace_back(new MemoryRingBuffer(capacity_bytes));
+            memory_ring_.store(retired_rings_.back().get(), std::memory_order_release);
+        }
+        updateHotLevels();
+    }
+
+    // 获取内存日志缓冲区中满足条件的日志
+    std::vector<MemoryLogRecord> snapshot(const LogFilter &filter = LogFilter()) const
+    {
+        MemoryRingBuffer *ring = memory_ring_.load(std::memory_order_acquire);
+        return ring ? ring->snapshot(filter) : std::vector<MemoryLogRecord>();
+    }
+
+#ifndef _WIN32
+    // 通过 Unix 域套接字提供内存日志查询服务
+    bool serveMemoryBuffer(const std::string &socket_path)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (hot_.shut_down)
+            return false;
+        memory_server_.reset();
+
+        std::unique_ptr<MemoryQueryServer> server(new MemoryQueryServer(
+            [this](const LogFilter &filter)
+            { return snapshot(filter); }));
+        if (!server->start(socket_path))
+            return false;
+        memory_server_ = std::move(server);
+        return true;
+    }
+
+    // 停止内存日志查询服务
+    void stopMemoryServer()
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        memory_server_.reset();
+    }
+#endif
+
+    // 是否会记录该等级和标签的日志（先比较等级闸门）
+    static bool enabled(LogLevel level, const char *tag = nullptr)
+    {
+        return static_cast<int>(level) >= LogGate::min_level.load(std::memory_order_relaxed) &&
+               instance().isEnabled(level, tag);
+    }
+
+    // 是否会记录该等级和标签的日志
+    bool isEnabled(LogLevel level, const char *tag = nullptr)
+    {
+        LogSite site;
+        return checkSite(level, tag, site);
+    }
+
+    // 检查等级和标签（内存缓冲区有独立的等级），结果保存到 site。
+    // 日志宏在求值参数之前调用，通过后用 logSite() 记录
+    bool checkSite(LogLevel level, const char *tag, LogSite &site)
+    {
+        site.level = level;
+        site.tag = tag;
+        return shouldLog(level, tag, site.state, site.to_outputs, site.memory);
+    }
+
+    // 日志记录函数 (printf 风格)
+    void log(LogLevel level, const char *tag, const char *file, int line, const char *function,
+             const char *format, ...)
+    {
+        LogSite site;
+        if (!checkSite(level, tag, site))
+            return;
+
+        va_list args;
+        va_start(args, format);
+        logSiteV(site, file, line, function, format, args);
+        va_end(args);
+    }
+
+    // 按 checkSite() 的结果记录一条日志，不再重复过滤
+    void logSite(const LogSite &site, const char *file, int line, const char *function, const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        logSiteV(site, file, line, function, format, args);
+        va_end(args);
+    }
+
+    // 按 checkSite() 的结果记录一条已格式化好的消息（流式日志使用）
+    void logMessage(const LogSite &site, const char *file, int line, const char *function, const char *message,
+                    size_t length)
+    {
+        LogRecord *record = RecordPool::acquire();
+        record->level = site.level;
+        bool line_color = appendPrefix(*record, site.level, site.tag, site.state, file, line, function);
+        record->append(message, length);
+        commitRecord(record, site.tag, site.state, site.memory, site.to_outputs, line_color);
+    }
+
+    // 创建批量日志：整批共用一个时间戳和一次过滤判断，commit 时一次性写出，
+    // 保证各行在输出中连续
+    LogBatch batch(LogLevel level, const char *tag = nullptr)
+    {
+        MemoryRingBuffer *memory = nullptr;
+        TagState *state = nullptr;
+        bool to_outputs = false;
+        if (!shouldLog(level, tag, state, to_outputs, memory))
+            return LogBatch();
+
+        LogBatch log_batch(this, level, tag, state, to_outputs, memory);
+        log_batch.line_color_ = appendPrefix(*log_batch.prefix_, level, tag, state, nullptr, 0, nullptr);
+        return log_batch;
+    }
+
+private:
+    void logSiteV(const LogSite &site, const char *file, int line, const char *function, const char *format,
+                  va_list args)
+    {
+        // 从当前线程的记录池取记录，稳定运行后不再分配内存
+        LogRecord *record = RecordPool::acquire();
+        record->level = site.level;
+        bool line_color = appendPrefix(*record, site.level, site.tag, site.state, file, line, function);
+
+        // 格式化消息
+        if (!appendMessage(*record, format, args))
+        {
+            RecordPool::release(record);
+            return; // 格式化错误
+        }
+
+        commitRecord(record, site.tag, site.state, site.memory, site.to_outputs, line_color);
+    }
+
+    Logger()
+        : file_writer_(nullptr), tag_count_(0), tag_published_(0), tag_overflow_(false), memory_ring_(nullptr)
+    {
+        for (auto &slot : tag_cache_)
+        {
+            slot.key.store(nullptr, std::memory_order_relaxed);
+            slot.state.store(nullptr, std::memory_order_relaxed);
+        }
+        for (auto &slot : tag_table_)
+        {
+            slot.store(nullptr, std::memory_order_relaxed);
+        }
+
+        // 预配置一些常用标签
+        configureTag("NETWORK", ansi::blue);
+        configureTag("DATABASE", ansi::magenta);
+        configureTag("UI", ansi::green);
+        configureTag("SYSTEM", ansi::yellow);
+        configureTag("SECURITY", ansi::red);
+
+        // 进程退出时写出缓冲区中的日志
+        std::atexit(&Logger::onExit);
+#if !defined(__APPLE__)
+        std::at_quick_exit(&Logger::onExit);
+#endif
+    }
+
+    // 禁止复制
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    // 实例从不析构（见 instance()），后台线程和文件由 shutdown() 停止和关闭
+    ~Logger() = delete;
+
+    // atexit/at_quick_exit 钩子
+    static void onExit()
+    {
+        instance().shutdown();
+    }
+
+    friend class LogBatch;
+
+    // 切换或关闭文件前写出异步缓冲区中的日志，需持有 mutex_
+    void flushFileWriter()
+    {
+        if (AsyncFileWriter *writer = file_writer_.load(std::memory_order_acquire))
+        {
+            writer->flush(std::chrono::milliseconds(1000));
+        }
+    }
+
+    // 结束一条日志并写到内存缓冲区、控制台和文件，之后释放记录
+    void commitRecord(LogRecord *record, const char *tag, TagState *state, MemoryRingBuffer *memory, bool to_outputs,
+                      bool line_color)
+    {
+        const LogLevel level = record->level;
+
+        // 整行颜色结束
+        if (line_color)
+        {
+            *record += ansi::reset;
+        }
+
+        // 写入内存缓冲区（无锁）
+        if (memory)
+        {
+            memory->push(level, tag, record->data(), record->size());
+        }
+
+        if (to_outputs)
+        {
+            *record += '\n';
+            writeOutputs(record, state);
+        }
+        RecordPool::release(record);
+
+        // Fatal 日志之后进程通常很快退出，确保已写出
+        if (level == LogLevel::Fatal)
+        {
+            flush();
+        }
+    }
+
+    // 过滤判断：标签是否启用、是否达到输出等级或内存缓冲区等级，同时取得标签状态
+    bool shouldLog(LogLevel level, const char *tag, TagState *&state, bool &to_outputs, MemoryRingBuffer *&memory)
+    {
+        // 低于所有等级下限的日志无需查找标签即可丢弃
+        if (level == LogLevel::OFF || level < hot_.min_level.load(std::memory_order_relaxed) ||
+            hot_.shut_down.load(std::memory_order_acquire))
+            return false;
+
+        state = tag ? findTag(tag) : nullptr;
+        memory = level >= hot_.memory_level.load(std::memory_order_relaxed)
+                     ? memory_ring_.load(std::memory_order_acquire)
+                     : nullptr;
+
+        // 没有标签级别和被禁用的标签时，只需读取热配置
+        if (!state || !hot_.has_tag_rules.load(std::memory_order_acquire))
+        {
+            to_outputs = level >= hot_.current_level.load(std::memory_order_relaxed);
+            return to_outputs || memory;
+        }
+
+        // 检查标签是否启用
+        if (!state->enabled.load(std::memory_order_relaxed))
+            return false;
+
+        LogLevel effective = state->has_level.load(std::memory_order_relaxed)
+                                 ? state->level.load(std::memory_order_relaxed)
+                                 : hot_.current_level.load(std::memory_order_relaxed);
+        to_outputs = level >= effective;
+        return to_outputs || memory;
+    }
+
+    // 查找标签状态：先按字符串地址查缓存（字符串常量地址固定），再按内容哈希无锁查找，
+    // 都未命中时才是新标签，加锁创建。日志路径上最多创建 kMaxTags 个标签状态，之后出现的
+    // 新标签返回空，按默认配置输出，不再加锁（配置接口创建的标签不受此限制）
+    TagState *findTag(const char *tag)
+    {
+        size_t index = static_cast<size_t>((static_cast<uint64_t>(reinterpret_cast<uintptr_t>(tag)) * 0x9E3779B97F4A7C15ULL) >>
+                                           (64 - kTagCacheBits));
+        TagCacheSlot *empty = nullptr;
+        for (size_t probe = 0; probe < kTagCacheProbes; ++probe)
+        {
+            TagCacheSlot &slot = tag_cache_[(index + probe) & (kTagCacheSize - 1)];
+            const char *key = slot.key.load(std::memory_order_acquire);
+            if (!key)
+            {
+                empty = &slot;
+                break;
+            }
+            if (key == tag)
+            {
+                // 同一地址可能是内容已改变的动态字符串，比较一次内容
+                TagState *state = slot.state.load(std::memory_order_acquire);
+                if (state && std::strcmp(state->name.c_str(), tag) == 0)
+                    return state;
+                break;
+            }
+        }
+
+        uint64_t hash = TagState::hashName(tag);
+        TagState *state = lookupTag(tag, hash);
+        if (!state)
+        {
+            // 超过上限后只有哈希表放不下的已配置标签才需要加锁查找
+            bool full = tag_count_.load(std::memory_order_acquire) >= kMaxTags;
+            if (full && !tag_overflow_.load(std::memory_order_acquire))
+                return nullptr;
+
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            if (full || tag_states_.size() >= kMaxTags)
+            {
+                auto it = tag_states_.find(tag);
+                if (it == tag_states_.end())
+                    return nullptr;
+                state = it->second.get();
+            }
+            else
+            {
+                state = internTag(tag);
+            }
+            if (!state->published)
+                return state; // 不在哈希表中，不记入地址缓存，下次仍按内容查找
+        }
+
+        // 记入地址缓存：槽位只写一次，先占键再写状态，读到空状态时按未命中处理
+        const char *expected = nullptr;
+        if (empty && empty->key.compare_exchange_strong(expected, tag, std::memory_order_acq_rel))
+        {
+            empty->state.store(state, std::memory_order_release);
+        }
+        return state;
     }
 
-    // 获取当前日志文件路径
-    std::string getLogFilePath() const
+    // 按内容哈希无锁查找标签状态（表的负载不超过一半，总能遇到空槽位）
+    TagState *lookupTag(const char *tag, uint64_t hash) const
     {
-        std::lock_guard<std::recursive_mutex> lock(mutex_);
-        return file_path_;
+        for (size_t i = static_cast<size_t>(hash) & (kTagTableSize - 1);; i = (i + 1) & (kTagTableSize - 1))
+        {
+            TagState *state = tag_table_[i].load(std::memory_order_acquire);
+            if (!state)
+                return nullptr;
+            if (state->hash == hash && std::strcmp(state->name.c_str(), tag) == 0)
+                return state;
+        }
     }
 
-    // 日志记录函数 (printf 风格)
-    void log(LogLevel level, const char *tag, const char *file, int line, const char *function,
-             const char *format, ...)
+    // 取得（必要时创建）标签状态，需持有 mutex_。数量上限由调用方（findTag）检查，
+    // 配置接口总是创建，保证配置生效。哈希表已满时不发布，由 findTag 加锁查找
+    TagState *internTag(const std::string &tag)
     {
-        if (level == LogLevel::OFF)
-            return;
+        auto it = tag_states_.find(tag);
+        if (it != tag_states_.end())
+            return it->second.get();
 
-        // 检查标签是否启用
-        if (tag)
+        TagState *state = new TagState(tag);
+        tag_states_[tag].reset(state);
+        refreshTagState(tag);
+
+        // 配置同步完成后再发布到哈希表
+        if (tag_published_ < kTagTableSize / 2)
         {
-            std::lock_guard<std::recursive_mutex> lock(mutex_);
-            auto tag_config_it = tag_configs_.find(tag);
-            if (tag_config_it != tag_configs_.end() && !tag_config_it->second.enabled)
+            size_t i = static_cast<size_t>(state->hash) & (kTagTableSize - 1);
+            while (tag_table_[i].load(std::memory_order_relaxed))
             {
-                return; // 标签被禁用
+                i = (i + 1) & (kTagTableSize - 1);
             }
+            state->published = true;
+            tag_table_[i].store(state, std::memory_order_release);
+            tag_published_++;
         }
-
-        // 检查日志级别
-        LogLevel effective_level = LogLevel::Info;
+        else
         {
-            std::lock_guard<std::recursive_mutex> lock(mutex_);
-            effective_level = getEffectiveLevel(tag);
+            tag_overflow_.store(true, std::memory_order_release);
         }
-        if (level < effective_level)
-            return;
+        tag_count_.store(tag_states_.size(), std::memory_order_release);
+        return state;
+    }
 
-        // 格式化消息 - 使用动态缓冲区防止截断
-        va_list args;
-        va_start(args, format);
-        // 获取所需缓冲区大小
-        int needed_size = vsnprintf(nullptr, 0, format, args);
-        va_end(args);
+    // 把标签配置同步到标签状态，需持有 mutex_
+    void refreshTagState(const std::string &tag)
+    {
+        TagState *state = internTag(tag);
 
-        if (needed_size < 0)
-            return; // 格式化错误
+        auto level_it = tag_levels_.find(tag);
+        state->has_level.store(level_it != tag_levels_.end(), std::memory_order_relaxed);
+        if (level_it != tag_levels_.end())
+        {
+            state->level.store(level_it->second, std::memory_order_relaxed);
+        }
 
-        std::vector<char> message_buffer(needed_size + 1); // +1 for null terminator
-        va_start(args, format);
-        vsnprintf(message_buffer.data(), message_buffer.size(), format, args);
-        va_end(args);
+        auto config_it = tag_configs_.find(tag);
+        TagConfig config = config_it != tag_configs_.end() ? config_it->second : TagConfig();
+        state->enabled.store(config.enabled, std::memory_order_relaxed);
+        state->color.store(config.color, std::memory_order_relaxed);
+        state->style.store(config.style, std::memory_order_relaxed);
+    }
 
-        std::string log_entry;
+    // 重新计算热配置中的等级下限，需持有 mutex_
+    void updateHotLevels()
+    {
+        LogLevel min_level = hot_.current_level;
+        for (const auto &item : tag_levels_)
         {
-            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            min_level = std::min(min_level, item.second);
+        }
+        if (memory_ring_.load(std::memory_order_relaxed))
+        {
+            min_level = std::min(min_level, hot_.memory_level.load());
+        }
 
-            // 获取高精度时间戳
-            std::string time_str = show_timestamp_ ? getHighPrecisionTimestamp() : "";
+        bool has_tag_rules = !tag_levels_.empty();
+        for (const auto &item : tag_configs_)
+        {
+            has_tag_rules = has_tag_rules || !item.second.enabled;
+        }
 
-            // 处理位置信息
-            std::string location_info;
-            if (file && function && location_mode_ != LocationDisplayMode::NONE)
-            {
-                location_info = getLocationInfo(file, function, line);
-            }
+        hot_.min_level.store(min_level, std::memory_order_relaxed);
+        LogGate::min_level.store(static_cast<int>(min_level), std::memory_order_relaxed);
+        hot_.has_tag_rules.store(has_tag_rules, std::memory_order_release);
+    }
 
-            // 创建日志流
-            std::ostringstream log_stream;
+    // 生成日志行前缀（颜色、时间戳、等级、标签、位置信息和消息前的空格），
+    // 返回是否整行着色（消息后需要追加 ansi::reset）
+    bool appendPrefix(LogRecord &out, LogLevel level, const char *tag, TagState *state, const char *file, int line,
+                      const char *function)
+    {
+        const ColorMode color_mode = hot_.color_mode.load(std::memory_order_relaxed);
 
-            // 整行颜色控制
-            if (color_mode_ == ColorMode::LINE)
-            {
-                log_stream << getLevelColor(level) << getLevelStyle(level);
-            }
+        // 整行颜色控制
+        if (color_mode == ColorMode::LINE)
+        {
+            out += getLevelColor(level);
+            out += getLevelStyle(level);
+        }
+
+        // 添加时间戳
+        if (hot_.show_timestamp)
+        {
+            appendTimestamp(out);
+        }
 
-            // 添加时间戳
-            log_stream << time_str;
+        // 添加日志级别
+        if (color_mode == ColorMode::TAG)
+        {
+            out += getLevelColor(level);
+            out += getLevelStyle(level);
+        }
+        out += '[';
+        out += levelToString(level);
+        out += ']';
+        if (color_mode == ColorMode::TAG)
+        {
+            out += ansi::reset;
+        }
 
-            // 添加日志级别
-            if (color_mode_ == ColorMode::TAG)
+        // 添加标签
+        if (hot_.show_tags.load(std::memory_order_relaxed) && tag && tag[0] != '\0')
+        {
+            if (color_mode == ColorMode::TAG)
             {
-                log_stream << getLevelColor(level) << getLevelStyle(level)
-                           << "[" << levelToString(level) << "]" << ansi::reset;
+                out += state ? state->style.load(std::memory_order_relaxed) : "";
+                out += state ? state->color.load(std::memory_order_relaxed) : ansi::cyan;
             }
-            else
+            out += '[';
+            out += tag;
+            out += ']';
+            if (color_mode == ColorMode::TAG)
             {
-                log_stream << "[" << levelToString(level) << "]";
+                out += ansi::reset;
             }
+        }
 
-            // 添加标签
-            if (show_tags_ && tag && tag[0] != '\0')
-            {
-                if (color_mode_ == ColorMode::TAG)
-                {
-                    TagConfig config = getTagConfig(tag);
-                    log_stream << config.style << config.color
-                               << "[" << tag << "]" << ansi::reset;
-                }
-                else
-                {
-                    log_stream << "[" << tag << "]";
-                }
-            }
+        // 添加位置信息
+        if (file && function && hot_.location_mode.load(std::memory_order_relaxed) != LocationDisplayMode::NONE)
+        {
+            appendLocation(out, file, function, line);
+        }
+        out += ' ';
+        return color_mode == ColorMode::LINE;
+    }
 
-            // 添加位置信息
-            log_stream << location_info;
+    // 把格式化后的消息追加到 out，直接格式化到记录的剩余空间中
+    bool appendMessage(LogRecord &out, const char *format, va_list args)
+    {
+        // 常用说明符走快速格式化，其余交给 vsnprintf
+        if (hot_.fast_format.load(std::memory_order_relaxed) && FastFormatter::format(out, format, args))
+            return true;
 
-            // 添加消息
-            log_stream << " " << message_buffer.data();
+        size_t old_size = out.size();
+        size_t available = out.capacity() - old_size;
+        va_list args_copy;
+        va_copy(args_copy, args);
+        int needed_size = vsnprintf(out.data() + old_size, available, format, args_copy);
+        va_end(args_copy);
 
-            // 整行颜色结束
-            if (color_mode_ == ColorMode::LINE)
-            {
-                log_stream << ansi::reset;
-            }
+        if (needed_size < 0)
+            return false;
 
-            // 输出日志
-            log_entry = log_stream.str();
+        // 剩余空间不足时扩容后重新格式化（+1 为结尾的 '\0'）
+        if (static_cast<size_t>(needed_size) >= available)
+        {
+            out.reserve(old_size + needed_size + 1);
+            vsnprintf(out.data() + old_size, needed_size + 1, format, args);
         }
+        out.resize(old_size + needed_size);
+        return true;
+    }
 
-        {
-            std::lock_guard<std::recursive_mutex> lock(mutex_);
+    // 把一行或多行完整日志（含换行）一次性写到控制台和文件，
+    // 异步输出只持有记录的引用，不复制内容
+    void writeOutputs(LogRecord *record, TagState *state)
+    {
+        if (hot_.shut_down)
+            return;
 
-            // 输出到控制台
-            if (console_output_)
+        // 输出到控制台
+        if (hot_.console_output)
+        {
+            std::lock_guard<std::mutex> output_lock(output_mutex_);
+            if (hot_.shut_down)
+                return;
+            if (console_sink_)
             {
-                std::cerr << log_entry << std::endl;
-                if (level >= LogLevel::Error)
-                {
-                    std::cerr.flush();
-                }
+                console_sink_->push(record);
             }
-
-            // 输出到文件
-            if (file_output_ && file_output_->is_open())
+            else
             {
-                *file_output_ << log_entry << std::endl;
-                if (level >= LogLevel::Error)
-                {
-                    file_output_->flush();
-                }
+                std::cerr.write(record->data(), record->size());
+                std::cerr.flush();
             }
         }
-    }
-
-private:
-    Logger()
-        : current_level_(LogLevel::Info),
-          console_output_(true),
-          color_mode_(ColorMode::TAG),
-          show_timestamp_(true),
-          timestamp_precision_(TimestampPrecision::MILLISECONDS),
-          location_mode_(LocationDisplayMode::FILENAME_ONLY),
-          show_tags_(true)
-    {
-        // 预配置一些常用标签
-        configureTag("NETWORK", ansi::blue);
-        configureTag("DATABASE", ansi::magenta);
-        configureTag("UI", ansi::green);
-        configureTag("SYSTEM", ansi::yellow);
-        configureTag("SECURITY", ansi::red);
-    }
-
-    // 禁止复制
-    Logger(const Logger &) = delete;
-    Logger &operator=(const Logger &) = delete;
 
-    ~Logger()
-    {
-        // 自动关闭文件
-        file_output_.reset();
+        // 输出到文件不经过输出锁：路由文件和同步写出只锁文件自己的锁，
+        // 异步写出只锁本节点队列的锁
+        FileSink *route = state ? state->sink.load(std::memory_order_acquire) : nullptr;
+        if (route)
+        {
+            route->write(record->data(), record->size(), 1, record->level >= LogLevel::Error);
+        }
+        else if (file_sink_.isOpen())
+        {
+            AsyncFileWriter *writer = file_writer_.load(std::memory_order_acquire);
+            if (writer)
+            {
+                writer->push(record);
+            }
+            else
+            {
+                file_sink_.write(record->data(), record->size(), 1, record->level >= LogLevel::Error);
+            }
+        }
     }
 
     // 检查目录是否存在
@@ -559,8 +3278,8 @@ private:
 #endif
     }
 
-    // 获取高精度时间戳
-    std::string getHighPrecisionTimestamp()
+    // 追加高精度时间戳，格式为 [YYYY-mm-dd HH:MM:SS.ffffff]
+    void appendTimestamp(LogRecord &out)
     {
         using namespace std::chrono;
 
@@ -576,101 +3295,89 @@ private:
         localtime_r(&now_time_t, &tm);
 #endif
 
-        // 格式化为字符串
-        std::ostringstream oss;
-        oss << "[" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
+        char buffer[40];
+        size_t length = std::strftime(buffer, sizeof(buffer), "[%Y-%m-%d %H:%M:%S", &tm);
 
         // 添加毫秒/微秒部分
         auto since_epoch = now.time_since_epoch();
-        auto sec_duration = duration_cast<std::chrono::seconds>(since_epoch);
-        since_epoch -= sec_duration;
+        since_epoch -= duration_cast<seconds>(since_epoch);
 
-        switch (timestamp_precision_)
+        long long fraction = 0;
+        int digits = 0;
+        switch (hot_.timestamp_precision)
         {
         case TimestampPrecision::MILLISECONDS:
-        {
-            auto milliseconds = duration_cast<std::chrono::milliseconds>(since_epoch);
-            oss << "." << std::setfill('0') << std::setw(3) << milliseconds.count();
+            fraction = duration_cast<milliseconds>(since_epoch).count();
+            digits = 3;
             break;
-        }
         case TimestampPrecision::MICROSECONDS:
-        {
-            auto microseconds = duration_cast<std::chrono::microseconds>(since_epoch);
-            oss << "." << std::setfill('0') << std::setw(6) << microseconds.count();
+            fraction = duration_cast<microseconds>(since_epoch).count();
+            digits = 6;
             break;
-        }
         default:
             break;
         }
-
-        oss << "]";
-        return oss.str();
+        if (digits > 0)
+        {
+            buffer[length++] = '.';
+            for (int i = digits - 1; i >= 0; --i)
+            {
+                buffer[length + i] = static_cast<char>('0' + fraction % 10);
+                fraction /= 10;
+            }
+            length += digits;
+        }
+        buffer[length++] = ']';
+        out.append(buffer, length);
     }
 
-    // 获取位置信息
-    std::string getLocationInfo(const char *file, const char *function, int line)
+    // 追加位置信息，格式为 [file:line-function]
+    void appendLocation(LogRecord &out, const char *file, const char *function, int line)
     {
-        if (!file || !function)
-            return "";
-
-        std::string file_str(file);
+        const char *file_name = file;
 
         // 根据模式处理文件路径
-        if (location_mode_ == LocationDisplayMode::FILENAME_ONLY)
+        LocationDisplayMode mode = hot_.location_mode.load(std::memory_order_relaxed);
+        if (mode == LocationDisplayMode::FILENAME_ONLY)
         {
             // 只显示文件名
-            size_t pos = file_str.find_last_of("/\\");
-            if (pos != std::string::npos)
+            for (const char *p = file; *p; ++p)
             {
-                file_str = file_str.substr(pos + 1);
+                if (*p == '/' || *p == '\\')
+                    file_name = p + 1;
             }
         }
-        else if (location_mode_ == LocationDisplayMode::RELATIVE_PATH && !base_path_.empty())
+        else if (mode == LocationDisplayMode::RELATIVE_PATH)
         {
-            // 显示相对路径
-            // 确保 base_path 以分隔符结尾
-            std::string normalized_base = base_path_;
-            if (normalized_base.back() != '/' && normalized_base.back() != '\\')
-            {
-                normalized_base += '/';
-            }
-
-            // 检查文件路径是否以 base_path 开头
-            if (file_str.find(normalized_base) == 0)
+            // 显示相对路径：文件路径以 base_path（视为以分隔符结尾）开头时去掉该前缀
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            size_t base_length = base_path_.size();
+            if (base_length > 0 && std::strncmp(file, base_path_.c_str(), base_length) == 0)
             {
-                file_str = file_str.substr(normalized_base.length());
+                char last = base_path_[base_length - 1];
+                if (last == '/' || last == '\\')
+                    file_name = file + base_length;
+                else if (file[base_length] == '/')
+                    file_name = file + base_length + 1;
             }
         }
         // FULL_PATH 模式保持原样
 
-        std::ostringstream loc_stream;
-        loc_stream << "[" << file_str << ":" << line << "-" << function << "]";
-        return loc_stream.str();
-    }
-
-    // 获取有效的日志级别（考虑标签特定级别）
-    LogLevel getEffectiveLevel(const char *tag)
-    {
-        if (!tag)
-            return current_level_;
-
-        auto it = tag_levels_.find(tag);
-        if (it != tag_levels_.end())
+        out += '[';
+        out += file_name;
+        out += ':';
+        if (line < 0)
         {
-            return it->second;
+            out += '-';
+            FastFormatter::appendDecimal(out, 0ULL - static_cast<unsigned long long>(line));
         }
-        return current_level_;
-    }
-
-    // 获取标签配置
-    TagConfig getTagConfig(const std::string &tag)
-    {
-        auto it = tag_configs_.find(tag);
-        if (it != tag_configs_.end())
+        else
         {
-            return it->second;
+            FastFormatter::appendDecimal(out, static_cast<unsigned long long>(line));
         }
-        return {ansi::cyan, "", true}; // 默认配置
+        out += '-';
+        out += function;
+        out += ']';
     }
 
     // 日志级别转字符串
@@ -717,43 +3424,389 @@ private:
         }
     }
 
+    // 读多写少的热配置：日志线程无锁读取，单独占用缓存行，
+    // 不会因为其他线程加解锁 mutex_ 而失效
+    struct alignas(64) HotConfig
+    {
+        std::atomic<LogLevel> min_level;                     // 全局/标签/内存缓冲区等级中的最小值
+        std::atomic<LogLevel> current_level;                 // 全局日志级别
+        std::atomic<LogLevel> memory_level;                  // 写入内存缓冲区的最低等级
+        std::atomic<bool> has_tag_rules;                     // 是否存在标签级别或被禁用的标签
+        std::atomic<bool> console_output;                    // 是否输出到控制台
+        std::atomic<ColorMode> color_mode;                   // 颜色模式
+        std::atomic<bool> show_timestamp;                    // 是否显示时间戳
+        std::atomic<TimestampPrecision> timestamp_precision; // 时间戳精度
+        std::atomic<LocationDisplayMode> location_mode;      // 位置信息显示模式
+        std::atomic<bool> show_tags;                         // 是否显示标签
+        std::atomic<bool> fast_format;                       // 是否启用快速格式化
+        std::atomic<bool> shut_down;                         // 是否已调用 shutdown()
+
+        HotConfig()
+            : min_level(LogLevel::Info),
+              current_level(LogLevel::Info),
+              memory_level(LogLevel::Trace),
+              has_tag_rules(false),
+              console_output(true),
+              color_mode(ColorMode::TAG),
+              show_timestamp(true),
+              timestamp_precision(TimestampPrecision::MILLISECONDS),
+              location_mode(LocationDisplayMode::FILENAME_ONLY),
+              show_tags(true),
+              fast_format(false),
+              shut_down(false)
+        {
+        }
+    };
+
     // 成员变量
-    LogLevel current_level_;
-    bool console_output_;                        // 是否输出到控制台
-    std::unique_ptr<std::ofstream> file_output_; // 文件输出流
-    std::string file_path_;                      // 当前日志文件路径
+    HotConfig hot_;
+
+    // 以下为加锁访问的可变状态，从新的缓存行开始
+    alignas(64) mutable std::recursive_mutex mutex_; // 配置锁
+    mutable std::mutex output_mutex_;                // 输出锁：控制台写入及 console_sink_ 的使用
+
+    std::unique_ptr<AsyncConsoleSink> console_sink_;                // 异步控制台输出（为空时同步写 std::cerr）
+    FileSink file_sink_;                                            // 日志文件
+    std::atomic<AsyncFileWriter *> file_writer_;                    // 异步文件写出（为空时同步写文件）
+    std::vector<std::unique_ptr<AsyncFileWriter>> retired_writers_; // 所有创建过的异步写出器
 
     std::unordered_map<std::string, LogLevel> tag_levels_;
     std::unordered_map<std::string, TagConfig> tag_configs_;
-
-    ColorMode color_mode_;
-    bool show_timestamp_;
-    TimestampPrecision timestamp_precision_;
-    LocationDisplayMode location_mode_;
+    std::unordered_map<std::string, std::unique_ptr<TagState>> tag_states_; // 标签运行时状态（不释放）
+    std::unordered_map<std::string, std::unique_ptr<FileSink>> route_sinks_; // 路径 -> 路由文件（shutdown 时关闭）
     std::string base_path_;
-    bool show_tags_;
 
-    mutable std::recursive_mutex mutex_;
+    // 字符串地址 -> 标签状态的无锁缓存（开放寻址，只增不删）
+    static const int kTagCacheBits = 8;
+    static const size_t kTagCacheSize = 1 << kTagCacheBits;
+    static const size_t kTagCacheProbes = 8;
+    struct TagCacheSlot
+    {
+        std::atomic<const char *> key;
+        std::atomic<TagState *> state;
+    };
+    TagCacheSlot tag_cache_[kTagCacheSize];
+
+    // 标签名哈希 -> 标签状态的无锁表（开放寻址，只增不删，负载不超过一半）。
+    // 日志路径上最多创建 kMaxTags 个标签，其余容量留给配置接口创建的标签
+    static const size_t kMaxTags = 4096;
+    static const size_t kTagTableSize = kMaxTags * 4;
+    std::atomic<TagState *> tag_table_[kTagTableSize];
+    std::atomic<size_t> tag_count_;  // 已创建的标签状态数
+    size_t tag_published_;           // 已发布到哈希表的标签数（需持有 mutex_）
+    std::atomic<bool> tag_overflow_; // 是否有标签因哈希表已满未发布
+
+    std::atomic<MemoryRingBuffer *> memory_ring_;                  // 内存日志缓冲区（为空时关闭）
+    std::vector<std::unique_ptr<MemoryRingBuffer>> retired_rings_; // 所有创建过的内存缓冲区
+#ifndef _WIN32
+    std::unique_ptr<MemoryQueryServer> memory_server_; // 内存日志查询服务
+#endif
+};
+
+// ======================
+// 批量日志实现
+// ======================
+inline LogBatch &LogBatch::add(const char *format, ...)
+{
+    if (!logger_)
+        return *this;
+
+    if (!record_)
+    {
+        record_ = RecordPool::acquire();
+        record_->level = level_;
+    }
+
+    size_t old_size = record_->size();
+    record_->append(prefix_->data(), prefix_->size());
+
+    va_list args;
+    va_start(args, format);
+    bool formatted = logger_->appendMessage(*record_, format, args);
+    va_end(args);
+    if (!formatted)
+    {
+        record_->resize(old_size); // 格式化错误，丢弃本行
+        return *this;
+    }
+
+    if (line_color_)
+    {
+        *record_ += ansi::reset;
+    }
+
+    // 写入内存缓冲区（不含换行）
+    if (memory_)
+    {
+        memory_->push(level_, tag_.c_str(), record_->data() + old_size, record_->size() - old_size);
+    }
+
+    *record_ += '\n';
+    lines_++;
+    return *this;
+}
+
+inline void LogBatch::commit()
+{
+    if (!logger_ || !record_)
+        return;
+
+    if (to_outputs_ && lines_ > 0)
+    {
+        logger_->writeOutputs(record_, tag_state_);
+    }
+
+    // 记录可能仍在异步队列中，之后的 add 使用新记录
+    RecordPool::release(record_);
+    record_ = nullptr;
+    lines_ = 0;
+}
+
+// ======================
+// 流式日志
+// ======================
+// LOG_*_S(tag) << a << b; 只有通过闸门时才会取出流对象，语句结束时写出。
+// 消息直接写入从池中取出的日志记录，不经过 ostringstream。流对象较大（含 std::ostream），
+// 每个线程缓存一个，取出和写出都在不内联的函数中完成，调用方的栈帧中只有 LogStreamGate
+class LogStream
+{
+public:
+    // 检查等级和标签并取出一个流对象，未通过时返回 nullptr
+    LITELOG_NOINLINE static LogStream *open(LogLevel level, const char *tag, const char *file, int line,
+                                            const char *function)
+    {
+        LogStream *stream = cached();
+        cached() = nullptr;
+        if (!stream)
+            stream = new LogStream();
+
+        if (!Logger::instance().checkSite(level, tag, stream->site_))
+        {
+            close(stream, false);
+            return nullptr;
+        }
+
+        // 标签表达式可能是临时对象，写出时已经销毁，因此改为引用标签状态中保存的名字
+        // （没有标签状态时复制到流对象中）
+        if (stream->site_.state)
+        {
+            stream->site_.tag = stream->site_.state->name.c_str();
+        }
+        else if (tag)
+        {
+            std::strncpy(stream->tag_copy_, tag, sizeof(stream->tag_copy_) - 1);
+            stream->tag_copy_[sizeof(stream->tag_copy_) - 1] = '\0';
+            stream->site_.tag = stream->tag_copy_;
+        }
+        stream->file_ = file;
+        stream->line_ = line;
+        stream->function_ = function;
+        stream->buffer_.record = RecordPool::acquire();
+        return stream;
+    }
+
+    // 写出日志（commit 为 true 时）并把流对象放回缓存
+    LITELOG_NOINLINE static void close(LogStream *stream, bool commit = true)
+    {
+        if (commit)
+        {
+            LogRecord *record = stream->buffer_.record;
+            Logger::instance().logMessage(stream->site_, stream->file_, stream->line_, stream->function_,
+                                          record->data(), record->size());
+            RecordPool::release(record);
+            stream->buffer_.record = nullptr;
+
+            // 恢复默认格式，下一条日志不受本条设置的影响
+            stream->stream_.clear();
+            stream->stream_.flags(std::ios_base::skipws | std::ios_base::dec);
+            stream->stream_.precision(6);
+            stream->stream_.width(0);
+            stream->stream_.fill(' ');
+        }
+
+        // 嵌套的流式日志（流输出中又记录日志）使用各自的对象，多出的直接释放
+        if (cached() || exited())
+        {
+            delete stream;
+            return;
+        }
+        holder();
+        cached() = stream;
+    }
+
+    std::ostream &stream()
+    {
+        return stream_;
+    }
+
+private:
+    // 把流输出追加到日志记录
+    struct RecordBuffer : public std::streambuf
+    {
+        RecordBuffer() : record(nullptr) {}
+
+        int_type overflow(int_type c) override
+        {
+            if (!traits_type::eq_int_type(c, traits_type::eof()))
+            {
+                *record += traits_type::to_char_type(c);
+            }
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const char *data, std::streamsize size) override
+        {
+            record->append(data, static_cast<size_t>(size));
+            return size;
+        }
+
+        LogRecord *record;
+    };
+
+    // 线程退出时释放缓存的流对象
+    struct Holder
+    {
+        ~Holder()
+        {
+            delete cached();
+            cached() = nullptr;
+            exited() = true;
+        }
+    };
+
+    LogStream() : file_(nullptr), line_(0), function_(nullptr), stream_(&buffer_) {}
+
+    LogStream(const LogStream &) = delete;
+    LogStream &operator=(const LogStream &) = delete;
+
+    static Holder &holder()
+    {
+        static thread_local Holder holder;
+        return holder;
+    }
+
+    static LogStream *&cached()
+    {
+        static thread_local LogStream *stream = nullptr;
+        return stream;
+    }
+
+    static bool &exited()
+    {
+        static thread_local bool exited = false;
+        return exited;
+    }
+
+    LogSite site_;
+    char tag_copy_[64];
+    const char *file_;
+    int line_;
+    const char *function_;
+    RecordBuffer buffer_;
+    std::ostream stream_;
+};
+
+// 流式日志宏的过滤：先比较等级闸门，通过后在循环条件中调用 open() 检查标签（level 和
+// tag 各只求值一次），通过后只执行一次循环体，析构时写出。对象只有两个指针大小，
+// 被过滤时调用方只做一次原子读取和一次分支
+class LogStreamGate
+{
+public:
+    explicit LogStreamGate(LogLevel level)
+        : stream_(nullptr), level_(level),
+          pending_(static_cast<int>(level) >= LogGate::min_level.load(std::memory_order_relaxed))
+    {
+    }
+
+    ~LogStreamGate()
+    {
+        if (stream_)
+            LogStream::close(stream_);
+    }
+
+    bool pending() const
+    {
+        return pending_;
+    }
+
+    // 只在第一次循环条件中调用
+    bool open(const char *tag, const char *file, int line, const char *function)
+    {
+        pending_ = false;
+        stream_ = LogStream::open(level_, tag, file, line, function);
+        return stream_ != nullptr;
+    }
+
+    std::ostream &stream()
+    {
+        return stream_->stream();
+    }
+
+private:
+    LogStreamGate(const LogStreamGate &) = delete;
+    LogStreamGate &operator=(const LogStreamGate &) = delete;
+
+    LogStream *stream_;
+    LogLevel level_;
+    bool pending_;
 };
 
+// ======================
+// 日志闸门
+// ======================
+// 先比较全局等级下限（一次原子读取和一次分支），通过后再检查标签级别和启用状态，
+// 都通过后才求值日志参数。level 和 tag 各只求值一次，过滤结果直接交给记录函数，
+// 不再重复检查；检查和记录在同一个完整表达式中，临时对象形式的标签在记录时仍然有效
+#define LITELOG_ENABLED(level, tag) Logger::enabled(level, tag)
+
+#define LITELOG_LOG(level, tag, fmt, ...)                                                                \
+    do                                                                                                   \
+    {                                                                                                    \
+        const LogLevel litelog_level_ = (level);                                                         \
+        if (static_cast<int>(litelog_level_) >= LogGate::min_level.load(std::memory_order_relaxed))      \
+        {                                                                                                \
+            Logger &litelog_logger_ = Logger::instance();                                                \
+            LogSite litelog_site_;                                                                       \
+            (void)(litelog_logger_.checkSite(litelog_level_, (tag), litelog_site_) &&                    \
+                   (litelog_logger_.logSite(litelog_site_, __FILE__, __LINE__, __func__, fmt,            \
+                                            ##__VA_ARGS__),                                              \
+                    true));                                                                              \
+        }                                                                                                \
+    } while (0)
+
+#define LITELOG_STREAM(level, tag)                                                                       \
+    for (LogStreamGate litelog_gate_((level));                                                           \
+         litelog_gate_.pending() && litelog_gate_.open((tag), __FILE__, __LINE__, __func__);)            \
+        litelog_gate_.stream()
+
 // ======================
 // 日志宏定义 (带标签)
 // ======================
-#define LOG_TRACE_T(tag, fmt, ...) Logger::instance().log(LogLevel::Trace, tag, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
-#define LOG_DEBUG_T(tag, fmt, ...) Logger::instance().log(LogLevel::Debug, tag, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
-#define LOG_INFO_T(tag, fmt, ...) Logger::instance().log(LogLevel::Info, tag, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
-#define LOG_WARN_T(tag, fmt, ...) Logger::instance().log(LogLevel::Warn, tag, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
-#define LOG_ERROR_T(tag, fmt, ...) Logger::instance().log(LogLevel::Error, tag, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
-#define LOG_FATAL_T(tag, fmt, ...) Logger::instance().log(LogLevel::Fatal, tag, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
+#define LOG_TRACE_T(tag, fmt, ...) LITELOG_LOG(LogLevel::Trace, tag, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG_T(tag, fmt, ...) LITELOG_LOG(LogLevel::Debug, tag, fmt, ##__VA_ARGS__)
+#define LOG_INFO_T(tag, fmt, ...) LITELOG_LOG(LogLevel::Info, tag, fmt, ##__VA_ARGS__)
+#define LOG_WARN_T(tag, fmt, ...) LITELOG_LOG(LogLevel::Warn, tag, fmt, ##__VA_ARGS__)
+#define LOG_ERROR_T(tag, fmt, ...) LITELOG_LOG(LogLevel::Error, tag, fmt, ##__VA_ARGS__)
+#define LOG_FATAL_T(tag, fmt, ...) LITELOG_LOG(LogLevel::Fatal, tag, fmt, ##__VA_ARGS__)
 
 // ======================
 // 日志宏定义 (无标签)
 // ======================
-#define LOG_TRACE(fmt, ...) Logger::instance().log(LogLevel::Trace, nullptr, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
-#define LOG_DEBUG(fmt, ...) Logger::instance().log(LogLevel::Debug, nullptr, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
-#define LOG_INFO(fmt, ...) Logger::instance().log(LogLevel::Info, nullptr, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
-#define LOG_WARN(fmt, ...) Logger::instance().log(LogLevel::Warn, nullptr, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
-#define LOG_ERROR(fmt, ...) Logger::instance().log(LogLevel::Error, nullptr, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
-#define LOG_FATAL(fmt, ...) Logger::instance().log(LogLevel::Fatal, nullptr, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
+#define LOG_TRACE(fmt, ...) LITELOG_LOG(LogLevel::Trace, nullptr, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(fmt, ...) LITELOG_LOG(LogLevel::Debug, nullptr, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...) LITELOG_LOG(LogLevel::Info, nullptr, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...) LITELOG_LOG(LogLevel::Warn, nullptr, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) LITELOG_LOG(LogLevel::Error, nullptr, fmt, ##__VA_ARGS__)
+#define LOG_FATAL(fmt, ...) LITELOG_LOG(LogLevel::Fatal, nullptr, fmt, ##__VA_ARGS__)
+
+// ======================
+// 日志宏定义 (流式，tag 可为 nullptr)
+// ======================
+#define LOG_TRACE_S(tag) LITELOG_STREAM(LogLevel::Trace, tag)
+#define LOG_DEBUG_S(tag) LITELOG_STREAM(LogLevel::Debug, tag)
+#define LOG_INFO_S(tag) LITELOG_STREAM(LogLevel::Info, tag)
+#define LOG_WARN_S(tag) LITELOG_STREAM(LogLevel::Warn, tag)
+#define LOG_ERROR_S(tag) LITELOG_STREAM(LogLevel::Error, tag)
+#define LOG_FATAL_S(tag) LITELOG_STREAM(LogLevel::Fatal, tag)
 
 #endif // _LITELOG_HPP_
\ No newline at end of file
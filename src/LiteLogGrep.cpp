@@ -0,0 +1,626 @@
+// litelog_grep: 离线分析 Logger::log 生成的日志文件
+//
+// 用 mmap 映射日志文件，按换行边界切分给多个线程并行扫描，解析
+// [时间戳][等级][标签][文件:行号-函数] 前缀，按等级、标签、时间范围和子串过滤，
+// 输出时去除 ColorMode::LINE/TAG 产生的 ANSI 颜色代码。
+//
+// 用法: litelog_grep [选项] 文件...
+//   -l LEVEL     最低等级 (TRACE/DEBUG/INFO/WARN/ERROR/FATAL)
+//   -t TAG       只保留该标签的日志，可重复指定
+//   -f TIME      起始时间（含），如 "2024-05-01 12:00:00"
+//   -u TIME      结束时间（含），按给定的位数比较，如 "2024-05-01 12:30"
+//   -s TEXT      日志行（去除颜色后）包含该子串
+//   -c           不输出日志行，按标签统计各等级的条数
+//   -j N         线程数（默认为 CPU 数）
+//
+// 与 grep 相同，有匹配的日志时返回 0，没有匹配时返回 1，出错时返回 2。
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+
+const char *const kLevelNames[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+const int kLevelCount = 6;
+
+// ======================
+// 过滤条件
+// ======================
+struct GrepOptions
+{
+    int min_level = 0;             // 最低等级
+    std::vector<std::string> tags; // 标签（为空表示不限）
+    std::string from;              // 起始时间（为空表示不限）
+    std::string until;             // 结束时间（为空表示不限）
+    std::string text;              // 子串（为空表示不限）
+    bool count = false;            // 是否只统计
+    unsigned threads = 0;          // 线程数
+
+    // 是否需要解析日志前缀
+    bool needsHeader() const
+    {
+        return min_level > 0 || !tags.empty() || !from.empty() || !until.empty() || count;
+    }
+};
+
+// 解析出的日志前缀，各字段指向去除颜色后的行内
+struct LogHeader
+{
+    const char *timestamp = nullptr;
+    size_t timestamp_len = 0;
+    int level = -1;
+    const char *tag = nullptr;
+    size_t tag_len = 0;
+};
+
+// 各标签的分等级计数
+typedef std::map<std::string, std::vector<uint64_t>> TagCounts;
+
+// ======================
+// 字节扫描
+// ======================
+// 查找 [p, end) 中第一个等于 a 或 b 的字节，找不到时返回 end。
+// SSE2 下每次比较 16 字节，其余平台逐字节比较。
+inline const char *findEither(const char *p, const char *end, char a, char b)
+{
+#if defined(__SSE2__)
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    while (end - p >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb)));
+        if (mask)
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+        p += 16;
+    }
+#endif
+    while (p < end && *p != a && *p != b)
+        ++p;
+    return p;
+}
+
+// 查找单个字节（libc 的 memchr 已向量化）
+inline const char *findByte(const char *p, const char *end, char c)
+{
+    const void *found = std::memchr(p, c, static_cast<size_t>(end - p));
+    return found ? static_cast<const char *>(found) : end;
+}
+
+// 查找子串
+inline bool containsText(const char *p, const char *end, const std::string &text)
+{
+    if (text.empty())
+        return true;
+    const char first = text[0];
+    while (static_cast<size_t>(end - p) >= text.size())
+    {
+        p = findByte(p, end - text.size() + 1, first);
+        if (p > end - text.size())
+            return false;
+        if (std::memcmp(p, text.data(), text.size()) == 0)
+            return true;
+        ++p;
+    }
+    return false;
+}
+
+// 去除 [p, end) 中的 ANSI 颜色代码（ESC [ ... 字母），结果写入 out
+inline void stripAnsi(const char *p, const char *end, std::string &out)
+{
+    out.clear();
+    while (p < end)
+    {
+        const char *esc = findByte(p, end, '\033');
+        out.append(p, esc - p);
+        if (esc == end)
+            break;
+        p = esc + 1;
+        if (p < end && *p == '[')
+        {
+            ++p;
+            while (p < end && !((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z')))
+                ++p;
+            if (p < end)
+                ++p;
+        }
+    }
+}
+
+// ======================
+// 前缀解析
+// ======================
+int parseLevel(const char *p, size_t length)
+{
+    for (int i = 0; i < kLevelCount; ++i)
+    {
+        if (std::strlen(kLevelNames[i]) == length && std::memcmp(kLevelNames[i], p, length) == 0)
+            return i;
+    }
+    return -1;
+}
+
+// 形如 file:123-function 的位置信息
+bool isLocation(const char *p, size_t length)
+{
+    const char *end = p + length;
+    for (const char *colon = findByte(p, end, ':'); colon < end; colon = findByte(colon + 1, end, ':'))
+    {
+        const char *q = colon + 1;
+        const char *digits = q;
+        while (q < end && *q >= '0' && *q <= '9')
+            ++q;
+        if (q > digits && q < end && *q == '-')
+            return true;
+    }
+    return false;
+}
+
+// 解析 [时间戳][等级][标签][位置] 前缀，行首不是该格式时返回 false
+bool parseHeader(const char *p, const char *end, LogHeader &header)
+{
+    const char *group[4];
+    size_t length[4];
+    size_t count = 0;
+    while (p < end && *p == '[' && count < 4)
+    {
+        const char *close = findByte(p + 1, end, ']');
+        if (close == end)
+            break;
+        group[count] = p + 1;
+        length[count] = static_cast<size_t>(close - p - 1);
+        ++count;
+        p = close + 1;
+    }
+
+    size_t index = 0;
+    if (index < count && length[index] > 0 && group[index][0] >= '0' && group[index][0] <= '9')
+    {
+        header.timestamp = group[index];
+        header.timestamp_len = length[index];
+        ++index;
+    }
+    if (index >= count)
+        return false;
+    header.level = parseLevel(group[index], length[index]);
+    if (header.level < 0)
+        return false;
+    ++index;
+
+    // 等级之后的一组是标签，除非它是最后一组且形如位置信息
+    if (index < count && !(index + 1 == count && isLocation(group[index], length[index])))
+    {
+        header.tag = group[index];
+        header.tag_len = length[index];
+    }
+    return true;
+}
+
+// ======================
+// 扫描
+// ======================
+struct ChunkResult
+{
+    uint64_t matches = 0;                                            // 匹配的日志条数
+    std::string output;                                              // 匹配的日志行
+    std::vector<std::pair<std::string, std::vector<uint64_t>>> counts; // 各标签的统计结果
+};
+
+class Scanner
+{
+public:
+    explicit Scanner(const GrepOptions &options) : options_(options) {}
+
+    // 扫描 [begin, end) 中的完整行
+    void scan(const char *begin, const char *end, ChunkResult &result)
+    {
+        const char *p = begin;
+        while (p < end)
+        {
+            // 一次扫描同时找到行尾和第一个颜色代码
+            const char *stop = findEither(p, end, '\n', '\033');
+            const char *eol = stop < end && *stop == '\033' ? findByte(stop, end, '\n') : stop;
+
+            const char *line = p;
+            const char *line_end = eol;
+            if (stop < eol)
+            {
+                stripAnsi(p, eol, plain_);
+                line = plain_.data();
+                line_end = line + plain_.size();
+            }
+            if (line_end > line && line_end[-1] == '\r')
+                --line_end;
+
+            processLine(line, line_end, result);
+            p = eol < end ? eol + 1 : end;
+        }
+    }
+
+private:
+    void processLine(const char *line, const char *end, ChunkResult &result)
+    {
+        LogHeader header;
+        if (options_.needsHeader())
+        {
+            if (!parseHeader(line, end, header) || !matchHeader(header))
+                return;
+        }
+        if (!containsText(line, end, options_.text))
+            return;
+
+        result.matches++;
+        if (options_.count)
+        {
+            countTag(header, result);
+        }
+        else
+        {
+            result.output.append(line, end - line);
+            result.output += '\n';
+        }
+    }
+
+    // 标签通常只有几个，线性查找并记住上一次命中的位置
+    void countTag(const LogHeader &header, ChunkResult &result)
+    {
+        const char *tag = header.tag ? header.tag : "-";
+        size_t tag_len = header.tag ? header.tag_len : 1;
+
+        auto &counts = result.counts;
+        if (last_tag_ >= counts.size() || counts[last_tag_].first.size() != tag_len ||
+            std::memcmp(counts[last_tag_].first.data(), tag, tag_len) != 0)
+        {
+            last_tag_ = 0;
+            while (last_tag_ < counts.size() &&
+                   (counts[last_tag_].first.size() != tag_len ||
+                    std::memcmp(counts[last_tag_].first.data(), tag, tag_len) != 0))
+            {
+                ++last_tag_;
+            }
+            if (last_tag_ == counts.size())
+            {
+                counts.push_back(std::make_pair(std::string(tag, tag_len), std::vector<uint64_t>(kLevelCount, 0)));
+            }
+        }
+        counts[last_tag_].second[header.level]++;
+    }
+
+    bool matchHeader(const LogHeader &header) const
+    {
+        if (header.level < options_.min_level)
+            return false;
+
+        if (!options_.tags.empty())
+        {
+            if (!header.tag)
+                return false;
+            bool found = false;
+            for (const auto &tag : options_.tags)
+            {
+                if (tag.size() == header.tag_len && std::memcmp(tag.data(), header.tag, header.tag_len) == 0)
+                {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found)
+                return false;
+        }
+
+        // 时间戳为定宽格式，按字典序比较即可
+        if (!options_.from.empty() || !options_.until.empty())
+        {
+            if (!header.timestamp)
+                return false;
+            const std::string &from = options_.from;
+            const std::string &until = options_.until;
+            if (!from.empty() && compareText(header.timestamp, header.timestamp_len, from.data(), from.size()) < 0)
+                return false;
+            if (!until.empty() &&
+                compareText(header.timestamp, std::min(header.timestamp_len, until.size()), until.data(), until.size()) > 0)
+                return false;
+        }
+        return true;
+    }
+
+    static int compareText(const char *a, size_t a_len, const char *b, size_t b_len)
+    {
+        int result = std::memcmp(a, b, std::min(a_len, b_len));
+        if (result != 0)
+            return result;
+        return a_len < b_len ? -1 : a_len > b_len ? 1 : 0;
+    }
+
+    const GrepOptions &options_;
+    std::string plain_;   // 去除颜色后的当前行
+    size_t last_tag_ = 0; // 上一次统计的标签下标
+};
+
+// 把 [data, data + size) 按换行边界切分为 count 段
+std::vector<std::pair<const char *, const char *>> splitChunks(const char *data, size_t size, size_t count)
+{
+    std::vector<std::pair<const char *, const char *>> chunks;
+    const char *end = data + size;
+    const char *begin = data;
+    for (size_t i = 1; i <= count && begin < end; ++i)
+    {
+        const char *cut = i == count ? end : data + size / count * i;
+        if (cut < begin)
+            cut = begin;
+        cut = cut < end ? findByte(cut, end, '\n') : end;
+        if (cut < end)
+            ++cut;
+        chunks.push_back(std::make_pair(begin, cut));
+        begin = cut;
+    }
+    return chunks;
+}
+
+// 按文件顺序写出一段的结果并累加统计
+void emitChunk(const ChunkResult &result, const char *path, bool show_name, TagCounts &totals)
+{
+    if (show_name)
+    {
+        const char *p = result.output.data();
+        const char *end = p + result.output.size();
+        while (p < end)
+        {
+            const char *eol = findByte(p, end, '\n');
+            std::printf("%s:%.*s\n", path, static_cast<int>(eol - p), p);
+            p = eol + 1;
+        }
+    }
+    else
+    {
+        std::fwrite(result.output.data(), 1, result.output.size(), stdout);
+    }
+
+    for (const auto &item : result.counts)
+    {
+        std::vector<uint64_t> &counts = totals[item.first];
+        counts.resize(kLevelCount, 0);
+        for (int level = 0; level < kLevelCount; ++level)
+            counts[level] += item.second[level];
+    }
+}
+
+// 扫描一个文件，累加匹配条数，返回是否成功
+bool grepFile(const char *path, const GrepOptions &options, bool show_name, TagCounts &totals, uint64_t &matches)
+{
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        std::fprintf(stderr, "litelog_grep: %s: %s\n", path, std::strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        std::fprintf(stderr, "litelog_grep: %s: %s\n", path, std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0)
+    {
+        ::close(fd);
+        return true;
+    }
+
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        std::fprintf(stderr, "litelog_grep: %s: %s\n", path, std::strerror(errno));
+        return false;
+    }
+    const char *data = static_cast<const char *>(mapped);
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    // 按固定大小分段，工作线程最多领先输出 window 段；当前线程按文件顺序写出
+    // 已完成的段并立即释放其结果，缓存的输出不超过 window 段，与文件大小无关
+    const size_t chunk_bytes = 4 << 20;
+    auto chunks = splitChunks(data, size, (size + chunk_bytes - 1) / chunk_bytes);
+    const size_t window = options.threads * 2;
+    std::vector<ChunkResult> results(chunks.size());
+    std::vector<bool> done(chunks.size(), false);
+
+    std::mutex mutex;
+    std::condition_variable done_cv;   // 有一段扫描完成
+    std::condition_variable window_cv; // 有一段已写出
+    size_t next = 0;                   // 下一个待扫描的段
+    size_t written = 0;                // 已写出的段数
+
+    auto worker = [&]()
+    {
+        Scanner scanner(options);
+        for (;;)
+        {
+            size_t i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                window_cv.wait(lock, [&]
+                               { return next >= chunks.size() || next < written + window; });
+                if (next >= chunks.size())
+                    return;
+                i = next++;
+            }
+            scanner.scan(chunks[i].first, chunks[i].second, results[i]);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done[i] = true;
+            }
+            done_cv.notify_one();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    size_t thread_count = std::min<size_t>(options.threads, chunks.size());
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done_cv.wait(lock, [&]
+                         { return done[i]; });
+        }
+        emitChunk(results[i], path, show_name, totals);
+        matches += results[i].matches;
+        std::string().swap(results[i].output); // 释放该段的输出缓冲区
+        results[i].counts.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            written = i + 1;
+        }
+        window_cv.notify_all();
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    munmap(mapped, size);
+    return true;
+}
+
+void printCounts(const TagCounts &totals)
+{
+    std::printf("%-20s", "TAG");
+    for (int level = 0; level < kLevelCount; ++level)
+        std::printf(" %10s", kLevelNames[level]);
+    std::printf(" %10s\n", "TOTAL");
+
+    for (const auto &item : totals)
+    {
+        uint64_t total = 0;
+        std::printf("%-20s", item.first.c_str());
+        for (int level = 0; level < kLevelCount; ++level)
+        {
+            std::printf(" %10llu", static_cast<unsigned long long>(item.second[level]));
+            total += item.second[level];
+        }
+        std::printf(" %10llu\n", static_cast<unsigned long long>(total));
+    }
+}
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "用法: litelog_grep [选项] 文件...\n"
+                 "  -l LEVEL   最低等级 (TRACE/DEBUG/INFO/WARN/ERROR/FATAL)\n"
+                 "  -t TAG     只保留该标签的日志，可重复指定\n"
+                 "  -f TIME    起始时间（含），如 \"2024-05-01 12:00:00\"\n"
+                 "  -u TIME    结束时间（含），按给定的位数比较，如 \"2024-05-01 12:30\"\n"
+                 "  -s TEXT    日志行包含该子串\n"
+                 "  -c         按标签统计各等级的条数\n"
+                 "  -j N       线程数（默认为 CPU 数）\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    GrepOptions options;
+    std::vector<const char *> files;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "-c")
+        {
+            options.count = true;
+        }
+        else if (arg == "-l" && has_value)
+        {
+            std::string level = argv[++i];
+            std::transform(level.begin(), level.end(), level.begin(), ::toupper);
+            options.min_level = parseLevel(level.data(), level.size());
+            if (options.min_level < 0)
+            {
+                std::fprintf(stderr, "litelog_grep: 未知的等级 %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (arg == "-t" && has_value)
+        {
+            options.tags.push_back(argv[++i]);
+        }
+        else if (arg == "-f" && has_value)
+        {
+            options.from = argv[++i];
+        }
+        else if (arg == "-u" && has_value)
+        {
+            options.until = argv[++i];
+        }
+        else if (arg == "-s" && has_value)
+        {
+            options.text = argv[++i];
+        }
+        else if (arg == "-j" && has_value)
+        {
+            options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        }
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            usage();
+            return 2;
+        }
+        else
+        {
+            files.push_back(argv[i]);
+        }
+    }
+
+    if (files.empty())
+    {
+        usage();
+        return 2;
+    }
+    if (options.threads == 0)
+    {
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    bool ok = true;
+    uint64_t matches = 0;
+    TagCounts totals;
+    for (const char *file : files)
+    {
+        ok = grepFile(file, options, files.size() > 1 && !options.count, totals, matches) && ok;
+    }
+    if (options.count)
+    {
+        printCounts(totals);
+    }
+    if (!ok)
+        return 2;
+    return matches > 0 ? 0 : 1;
+}
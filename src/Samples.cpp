@@ -96,6 +96,19 @@ int main()
 
     std::cout << std::endl;
 
+    // 批量日志：一次时间戳、一次写出，各行保持连续
+    LOG_INFO("=== 批量日志演示 ===");
+    {
+        auto batch = Logger::instance().batch(LogLevel::Info, "DATABASE");
+        for (int i = 0; i < 3; i++)
+        {
+            batch.add("查询结果 第%d行: id=%d", i, 1000 + i);
+        }
+        batch.commit();
+    }
+
+    std::cout << std::endl;
+
     // 演示不同时间精度
     LOG_INFO("=== 时间戳精度演示 ===");
 